@@ -0,0 +1,660 @@
+#include "channel.h"
+#include "dsp_common.h"
+#include "fft_engine.h"
+#include "noise.h"
+#include "nco.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MULTIPATH_MAX_TAPS 8
+// Smallest overlap-save transform; it is grown to at least four times the
+// filter so most of each transform is output
+#define CHANNEL_MIN_FFT 1024
+// Fractional bits of the quantised phase noise
+#define PHASE_NOISE_BITS 20
+// Phase noise samples generated at a time
+#define PHASE_NOISE_BATCH 1024
+// Longest phase noise filter run at every sample. A longer one is run on a
+// grid of every phase_noise_step samples and interpolated between, like
+// the fading gains, so starting it costs a call at most 2 * this.
+#define PHASE_NOISE_MAX_TAPS 256
+// Sinusoids per quadrature branch of a fading tap
+#define FADING_SINUSOIDS 16
+// Evaluated gains per period of the highest Doppler shift; linear
+// interpolation between them is then within about 0.1% of the exact gain
+#define FADING_POINTS_PER_CYCLE 64
+#define FADING_MAX_STEP 256
+
+typedef struct {
+    double delay; // symbol periods
+    double gain;
+    double phase_deg;
+} MultipathTap;
+
+typedef struct {
+    const char* name;
+    int tap_count;
+    MultipathTap taps[MULTIPATH_MAX_TAPS];
+} MultipathDefinition;
+
+// Static profiles in symbol periods, so the intersymbol interference they
+// cause looks the same at any samples per symbol. Gains are normalised to
+// unit total power when the channel is built.
+static const MultipathDefinition multipath_profiles[MULTIPATH_PROFILE_COUNT] = {
+    { "none", 1, { {0.0, 1.0, 0.0} } },
+    { "two-ray", 2, { {0.0, 1.0, 0.0}, {0.5, 0.5, 60.0} } },
+    { "three-ray", 3, { {0.0, 1.0, 0.0}, {0.3, 0.6, -45.0}, {1.1, 0.3, 120.0} } },
+    { "dense", 8, { {0.0, 1.0, 0.0}, {0.15, 0.8, -30.0}, {0.3, 0.63, 75.0}, {0.5, 0.5, 160.0},
+                    {0.75, 0.4, -110.0}, {1.0, 0.32, 20.0}, {1.4, 0.25, -150.0}, {2.0, 0.16, 95.0} } },
+};
+
+// One tap of the fading delay line. Every sinusoid is a 32-bit phase
+// ramp like the NCO's, so the gain at any sample index is exact.
+typedef struct {
+    int delay;
+    double scatter_gain; // per sinusoid
+    double los_gain;     // 0 unless Rician
+    uint32_t increment_I[FADING_SINUSOIDS];
+    uint32_t increment_Q[FADING_SINUSOIDS];
+    uint32_t phase_I[FADING_SINUSOIDS];
+    uint32_t phase_Q[FADING_SINUSOIDS];
+    uint32_t los_increment;
+    uint32_t los_phase;
+} FadingTap;
+
+typedef struct {
+    int64_t samples;
+    int64_t gain_updates;
+    int64_t nanoseconds;
+} FadingCounters;
+
+struct Channel {
+    ChannelParams params;
+    double signal_power;
+    double noise_std_dev; // 0 when noiseless
+
+    // The analytic filter (Hilbert FIR convolved with the multipath taps)
+    // as a spectrum of fft_size bins, pre-scaled for the unscaled inverse
+    bool filtered;
+    int history;
+    int lookahead;
+    int filter_length;
+    int fft_size;
+    FftPlan* plan;
+    FftRealPlan* real_plan; // forward transform of the real input blocks
+    double* filter_real;    // spectrum of the analytic filter
+    double* filter_imag;
+
+    // Rotation by the frequency offset and phase noise, in 32-bit phase
+    // units like the NCO
+    uint32_t cfo_increment;
+    uint32_t carrier_increment;
+    int phase_noise_length; // in grid points, 0 when off
+    int phase_noise_step; // samples between grid points, a power of two
+    double phase_noise_scale; // second-stage sum to phase units
+
+    // Front end: mu * z + nu * conj(z) at baseband, then DC
+    bool imbalanced;
+    double mu_real, mu_imag;
+    double nu_real, nu_imag;
+    double dc_I, dc_Q;
+
+    // Time-varying taps in place of the fixed multipath filter
+    FadingTap* fading_taps; // NULL when fading is off
+    int fading_tap_count;
+    int fading_step; // samples between evaluated gains, a power of two
+    FadingCounters* counters; // updated by const calls from any thread
+};
+
+// Phase noise is white noise through a triangular filter (two moving sums
+// of 'length'), computed on integers at every step-th sample and linearly
+// interpolated between. Sums of integers are exact, so the phase at a
+// sample doesn't depend on where the sums were started from.
+typedef struct {
+    int length;
+    int head;
+    int32_t* q;   // the last 'length' noise samples, oldest at head
+    int64_t* s1;  // the last 'length' first-stage sums
+    int64_t sum1;
+    int64_t sum2;
+    int64_t next; // grid index of the next noise sample
+    uint64_t seed;
+    int32_t batch[PHASE_NOISE_BATCH];
+    int batch_used;
+    int step;
+    int offset;   // of the next sample from grid point 'from'
+    int64_t from; // the sums at the grid points either side
+    int64_t to;
+    double slope;
+} PhaseNoise;
+
+// Unit normal noise of the phase stream, quantised to PHASE_NOISE_BITS
+static void quantised_noise(uint64_t seed, int64_t first, int32_t* out, int n) {
+    double buffer[PHASE_NOISE_BATCH];
+    for (int done = 0; done < n; done += PHASE_NOISE_BATCH) {
+        int count = n - done < PHASE_NOISE_BATCH ? n - done : PHASE_NOISE_BATCH;
+        memset(buffer, 0, count * sizeof(double));
+        noise_add(seed, NOISE_STREAM_PHASE, first + done, buffer, count, 1.0);
+        for (int i = 0; i < count; ++i) out[done + i] = (int32_t)lrint(buffer[i] * (1 << PHASE_NOISE_BITS));
+    }
+}
+
+static inline int64_t phase_noise_grid_step(PhaseNoise* pn) {
+    if (pn->batch_used == PHASE_NOISE_BATCH) {
+        quantised_noise(pn->seed, pn->next, pn->batch, PHASE_NOISE_BATCH);
+        pn->batch_used = 0;
+    }
+    int32_t q = pn->batch[pn->batch_used++];
+    pn->sum1 += q - pn->q[pn->head];
+    pn->sum2 += pn->sum1 - pn->s1[pn->head];
+    pn->q[pn->head] = q;
+    pn->s1[pn->head] = pn->sum1;
+    if (++pn->head == pn->length) pn->head = 0;
+    pn->next++;
+    return pn->sum2;
+}
+
+// Sets the filter up for sample 'start', with the history taken from
+// 'workspace'. The sums are primed from the 2 * length - 1 grid points
+// before the one at or before 'start'.
+static bool phase_noise_start(PhaseNoise* pn, int length, int step, uint64_t seed, int64_t start, Workspace* workspace) {
+    int L = length;
+    pn->length = L;
+    pn->seed = seed;
+    pn->q = (int32_t*)workspace_alloc(workspace, L * sizeof(int32_t));
+    pn->s1 = (int64_t*)workspace_alloc(workspace, L * sizeof(int64_t));
+    int32_t* past = (int32_t*)workspace_alloc(workspace, (2 * L - 1) * sizeof(int32_t));
+    if (pn->q == NULL || pn->s1 == NULL || past == NULL) return false;
+
+    pn->step = step;
+    pn->offset = (int)((start % step + step) % step);
+    int64_t anchor = (start - pn->offset) / step;
+
+    // Noise for grid points anchor - 2L + 1 .. anchor - 1
+    quantised_noise(seed, anchor - 2 * L + 1, past, 2 * L - 1);
+    int64_t sum1 = 0;
+    for (int k = 0; k < L; ++k) sum1 += past[k];
+    pn->s1[0] = sum1;
+    for (int k = 1; k < L; ++k) {
+        sum1 += past[L - 1 + k] - past[k - 1];
+        pn->s1[k] = sum1;
+    }
+    int64_t sum2 = 0;
+    for (int k = 0; k < L; ++k) sum2 += pn->s1[k];
+    memcpy(pn->q, past + L - 1, L * sizeof(int32_t));
+
+    pn->sum1 = sum1;
+    pn->sum2 = sum2;
+    pn->head = 0;
+    pn->next = anchor;
+    pn->batch_used = PHASE_NOISE_BATCH;
+
+    pn->from = phase_noise_grid_step(pn);
+    pn->to = phase_noise_grid_step(pn);
+    pn->slope = (double)(pn->to - pn->from) / step;
+    return true;
+}
+
+// The second-stage sum at the next sample
+static inline double phase_noise_next(PhaseNoise* pn) {
+    if (pn->offset == pn->step) {
+        pn->from = pn->to;
+        pn->to = phase_noise_grid_step(pn);
+        pn->slope = (double)(pn->to - pn->from) / pn->step;
+        pn->offset = 0;
+    }
+    return (double)pn->from + pn->slope * pn->offset++;
+}
+
+// Blackman-windowed 2 / (pi k) at the odd lags
+void channel_hilbert_taps(double* taps) {
+    const int D = CHANNEL_HILBERT_HALF;
+    for (int k = 0; k <= D; ++k) {
+        if ((k & 1) == 0) {
+            taps[k] = 0.0;
+            continue;
+        }
+        double window = 0.42 + 0.5 * cos(M_PI * k / D) + 0.08 * cos(2.0 * M_PI * k / D);
+        taps[k] = 2.0 / (M_PI * k) * window;
+    }
+}
+
+// Windowed Hilbert FIR folded into the analytic filter: g = delta + j*h,
+// centred on CHANNEL_HILBERT_HALF
+static void analytic_filter_add(double* filter_real, double* filter_imag, int delay, double gain_real, double gain_imag) {
+    const int D = CHANNEL_HILBERT_HALF;
+    double hilbert[CHANNEL_HILBERT_HALF + 1];
+    channel_hilbert_taps(hilbert);
+    filter_real[delay + D] += gain_real;
+    filter_imag[delay + D] += gain_imag;
+    for (int k = -D; k <= D; ++k) {
+        if ((k & 1) == 0) continue;
+        double h = k > 0 ? hilbert[k] : -hilbert[-k];
+        // (gain_real + j gain_imag) * (j h)
+        filter_real[delay + D + k] -= gain_imag * h;
+        filter_imag[delay + D + k] += gain_real * h;
+    }
+}
+
+// Uniform in [0, 1), from the fading stream's Gaussian noise through the
+// normal CDF
+static double fading_uniform(uint64_t seed, int64_t index) {
+    return 0.5 * erfc(-noise_at(seed, NOISE_STREAM_FADING, index) / sqrt(2.0));
+}
+
+static uint32_t fading_phase(uint64_t seed, int64_t index) {
+    return (uint32_t)(uint64_t)(fading_uniform(seed, index) * 4294967296.0);
+}
+
+// Zheng and Xiao's sum of sinusoids: branch I runs at doppler * cos(a_m)
+// and Q at doppler * sin(a_m), a_m = (2 pi m - pi + theta) / 4M, with theta
+// and every phase random per tap. That gives the Clarke/Jakes spectrum
+// with only FADING_SINUSOIDS terms per branch.
+static bool build_fading(Channel* channel, int samples_per_symbol, double sampling_rate) {
+    const MultipathDefinition* profile = &multipath_profiles[channel->params.multipath];
+    channel->fading_taps = (FadingTap*)calloc(profile->tap_count, sizeof(FadingTap));
+    if (channel->fading_taps == NULL) return false;
+    channel->fading_tap_count = profile->tap_count;
+
+    double total_power = 0.0;
+    for (int p = 0; p < profile->tap_count; ++p) total_power += profile->taps[p].gain * profile->taps[p].gain;
+    double k = channel->params.fading == FADING_RICIAN ? pow(10.0, channel->params.rician_k_db / 10.0) : 0.0;
+    double doppler = fabs(channel->params.doppler_hz);
+    uint64_t seed = channel->params.noise_seed;
+    const int draws = 2 * FADING_SINUSOIDS + 2;
+
+    for (int p = 0; p < profile->tap_count; ++p) {
+        FadingTap* tap = &channel->fading_taps[p];
+        double gain = profile->taps[p].gain / sqrt(total_power);
+        double los_share = p == 0 ? k / (k + 1.0) : 0.0;
+        tap->delay = (int)lround(profile->taps[p].delay * samples_per_symbol);
+        tap->scatter_gain = gain * sqrt((1.0 - los_share) / FADING_SINUSOIDS);
+        tap->los_gain = gain * sqrt(los_share);
+
+        int64_t base = (int64_t)p * draws;
+        double theta = (2.0 * fading_uniform(seed, base) - 1.0) * M_PI;
+        for (int m = 0; m < FADING_SINUSOIDS; ++m) {
+            double alpha = (2.0 * M_PI * (m + 1) - M_PI + theta) / (4.0 * FADING_SINUSOIDS);
+            tap->increment_I[m] = nco_increment(doppler * cos(alpha), sampling_rate);
+            tap->increment_Q[m] = nco_increment(doppler * sin(alpha), sampling_rate);
+            tap->phase_I[m] = fading_phase(seed, base + 2 + 2 * m);
+            tap->phase_Q[m] = fading_phase(seed, base + 3 + 2 * m);
+        }
+        tap->los_increment = nco_increment(doppler * cos(M_PI / 4.0), sampling_rate);
+        tap->los_phase = fading_phase(seed, base + 1);
+    }
+
+    channel->fading_step = FADING_MAX_STEP;
+    while (channel->fading_step > 1 && doppler * channel->fading_step * FADING_POINTS_PER_CYCLE > sampling_rate) {
+        channel->fading_step >>= 1;
+    }
+    return true;
+}
+
+static void fading_gain(const FadingTap* tap, int64_t index, double* gain_real, double* gain_imag) {
+    uint64_t n = (uint64_t)index;
+    double sum_I = 0.0, sum_Q = 0.0;
+    for (int m = 0; m < FADING_SINUSOIDS; ++m) {
+        sum_I += nco_cos((uint32_t)(n * tap->increment_I[m]) + tap->phase_I[m], NCO_PRECISION_INTERP_LUT);
+        sum_Q += nco_cos((uint32_t)(n * tap->increment_Q[m]) + tap->phase_Q[m], NCO_PRECISION_INTERP_LUT);
+    }
+    uint32_t los = (uint32_t)(n * tap->los_increment) + tap->los_phase;
+    *gain_real = tap->scatter_gain * sum_I + tap->los_gain * nco_cos(los, NCO_PRECISION_INTERP_LUT);
+    *gain_imag = tap->scatter_gain * sum_Q + tap->los_gain * nco_sin(los, NCO_PRECISION_INTERP_LUT);
+}
+
+// out[i] = sum over taps of gain(first + i) * z[i - delay]. The gains are
+// evaluated at multiples of fading_step and interpolated in between, so
+// every sample sees the same gains wherever a block starts.
+static void fading_apply(const Channel* channel, int64_t first, const double* z_real, const double* z_imag,
+                         double* out_real, double* out_imag, int n) {
+    const int step = channel->fading_step;
+    int64_t updates = 0;
+    for (int i = 0; i < n; ++i) {
+        out_real[i] = 0.0;
+        out_imag[i] = 0.0;
+    }
+
+    int64_t first_anchor = first - (first % step + step) % step;
+    for (int t = 0; t < channel->fading_tap_count; ++t) {
+        const FadingTap* tap = &channel->fading_taps[t];
+        const double* delayed_real = z_real - tap->delay;
+        const double* delayed_imag = z_imag - tap->delay;
+        int64_t anchor = first_anchor;
+        double g0_real, g0_imag;
+        fading_gain(tap, anchor, &g0_real, &g0_imag);
+        updates++;
+
+        for (int i = 0; i < n; anchor += step) {
+            double g1_real, g1_imag;
+            fading_gain(tap, anchor + step, &g1_real, &g1_imag);
+            updates++;
+            double slope_real = (g1_real - g0_real) / step;
+            double slope_imag = (g1_imag - g0_imag) / step;
+            int end = anchor + step - first < n ? (int)(anchor + step - first) : n;
+            for (; i < end; ++i) {
+                double offset = (double)(first + i - anchor);
+                double h_real = g0_real + slope_real * offset;
+                double h_imag = g0_imag + slope_imag * offset;
+                out_real[i] += h_real * delayed_real[i] - h_imag * delayed_imag[i];
+                out_imag[i] += h_real * delayed_imag[i] + h_imag * delayed_real[i];
+            }
+            g0_real = g1_real;
+            g0_imag = g1_imag;
+        }
+    }
+
+    __atomic_fetch_add(&channel->counters->samples, n, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&channel->counters->gain_updates, updates, __ATOMIC_RELAXED);
+}
+
+// CPU time of the calling thread, so the workers' sums don't count time
+// spent waiting or descheduled. Wall time where there is no such clock.
+static int64_t thread_nanoseconds(void) {
+    struct timespec ts;
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static bool build_filter(Channel* channel, int samples_per_symbol) {
+    const MultipathDefinition* profile = &multipath_profiles[channel->params.multipath];
+
+    int max_delay = 0;
+    double total_power = 0.0;
+    for (int p = 0; p < profile->tap_count; ++p) {
+        int delay = (int)lround(profile->taps[p].delay * samples_per_symbol);
+        if (delay > max_delay) max_delay = delay;
+        total_power += profile->taps[p].gain * profile->taps[p].gain;
+    }
+
+    channel->filter_length = max_delay + 2 * CHANNEL_HILBERT_HALF + 1;
+    channel->history = max_delay + CHANNEL_HILBERT_HALF;
+    channel->lookahead = CHANNEL_HILBERT_HALF;
+    channel->fft_size = CHANNEL_MIN_FFT;
+    while (channel->fft_size < 4 * channel->filter_length) channel->fft_size <<= 1;
+
+    channel->filter_real = fft_buffer_alloc(channel->fft_size);
+    channel->filter_imag = fft_buffer_alloc(channel->fft_size);
+    channel->plan = fft_plan_create(channel->fft_size);
+    channel->real_plan = fft_real_plan_create(channel->fft_size);
+    if (channel->filter_real == NULL || channel->filter_imag == NULL ||
+        channel->plan == NULL || channel->real_plan == NULL) return false;
+    memset(channel->filter_real, 0, channel->fft_size * sizeof(double));
+    memset(channel->filter_imag, 0, channel->fft_size * sizeof(double));
+
+    // With fading the filter is the Hilbert FIR alone. Its output still
+    // lines up with the static case, and the samples before it (back to
+    // the longest delay) are valid too, so the taps can read them.
+    if (channel->fading_taps != NULL) analytic_filter_add(channel->filter_real, channel->filter_imag, 0, 1.0, 0.0);
+
+    double norm = 1.0 / sqrt(total_power);
+    for (int p = 0; channel->fading_taps == NULL && p < profile->tap_count; ++p) {
+        int delay = (int)lround(profile->taps[p].delay * samples_per_symbol);
+        double phase = profile->taps[p].phase_deg * M_PI / 180.0;
+        double gain = profile->taps[p].gain * norm;
+        analytic_filter_add(channel->filter_real, channel->filter_imag, delay, gain * cos(phase), gain * sin(phase));
+    }
+
+    fft_forward(channel->plan, channel->filter_real, channel->filter_imag);
+    for (int k = 0; k < channel->fft_size; ++k) {
+        channel->filter_real[k] /= channel->fft_size;
+        channel->filter_imag[k] /= channel->fft_size;
+    }
+    return true;
+}
+
+Channel* channel_create(const ChannelParams* params, double sampling_rate, double carrier_frequency,
+                        int samples_per_symbol, double signal_power) {
+    Channel* channel = (Channel*)calloc(1, sizeof(Channel));
+    if (channel == NULL) return NULL;
+
+    channel->params = *params;
+    if (channel->params.multipath < MULTIPATH_NONE || channel->params.multipath > MULTIPATH_DENSE) {
+        channel->params.multipath = MULTIPATH_NONE;
+    }
+    channel->signal_power = signal_power;
+    double rms = sqrt(signal_power > 0.0 ? signal_power : 0.0);
+
+    if (params->snr_db < CHANNEL_SNR_NOISELESS && signal_power > 0.0) {
+        channel->noise_std_dev = sqrt(signal_power / pow(10.0, params->snr_db / 10.0));
+    }
+
+    channel->cfo_increment = nco_increment(params->cfo_hz, sampling_rate);
+    channel->carrier_increment = nco_increment(carrier_frequency, sampling_rate);
+
+    if (params->phase_noise_deg > 0.0) {
+        long length = params->phase_noise_bandwidth > 0.0 ? lround(0.32 * sampling_rate / params->phase_noise_bandwidth) : 1;
+        if (length < 1) length = 1;
+        if (length > CHANNEL_PHASE_NOISE_MAX_LENGTH) length = CHANNEL_PHASE_NOISE_MAX_LENGTH;
+        int step = 1;
+        while (length / step > PHASE_NOISE_MAX_TAPS) step <<= 1;
+        length = lround((double)length / step);
+        if (length < 1) length = 1;
+        double L = (double)length;
+        double filter_rms = sqrt(L * (2.0 * L * L + 1.0) / 3.0) * (1 << PHASE_NOISE_BITS);
+        channel->phase_noise_length = (int)length;
+        channel->phase_noise_step = step;
+        channel->phase_noise_scale = params->phase_noise_deg / 360.0 * 4294967296.0 / filter_rms;
+    }
+
+    // mu = (1 + g e^-jphi) / 2, nu = (1 - g e^jphi) / 2
+    if (params->iq_gain_db != 0.0 || params->iq_phase_deg != 0.0) {
+        double g = pow(10.0, params->iq_gain_db / 20.0);
+        double phi = params->iq_phase_deg * M_PI / 180.0;
+        channel->imbalanced = true;
+        channel->mu_real = (1.0 + g * cos(phi)) / 2.0;
+        channel->mu_imag = -g * sin(phi) / 2.0;
+        channel->nu_real = (1.0 - g * cos(phi)) / 2.0;
+        channel->nu_imag = -g * sin(phi) / 2.0;
+    } else {
+        channel->mu_real = 1.0;
+    }
+    channel->dc_I = params->dc_offset * rms;
+    channel->dc_Q = params->dc_offset * rms;
+
+    if (channel->params.fading < FADING_NONE || channel->params.fading > FADING_RICIAN) {
+        channel->params.fading = FADING_NONE;
+    }
+    channel->counters = (FadingCounters*)calloc(1, sizeof(FadingCounters));
+    if (channel->counters == NULL ||
+        (channel->params.fading != FADING_NONE && !build_fading(channel, samples_per_symbol, sampling_rate))) {
+        channel_destroy(channel);
+        return NULL;
+    }
+
+    channel->filtered = channel->params.multipath != MULTIPATH_NONE || channel->cfo_increment != 0 ||
+                        channel->phase_noise_length > 0 || channel->imbalanced || channel->fading_taps != NULL;
+    if (channel->filtered && !build_filter(channel, samples_per_symbol)) {
+        channel_destroy(channel);
+        return NULL;
+    }
+    return channel;
+}
+
+void channel_destroy(Channel* channel) {
+    if (channel == NULL) return;
+    aligned_buffer_free(channel->filter_real);
+    aligned_buffer_free(channel->filter_imag);
+    fft_plan_destroy(channel->plan);
+    fft_real_plan_destroy(channel->real_plan);
+    free(channel->fading_taps);
+    free(channel->counters);
+    free(channel);
+}
+
+bool channel_params_equal(const ChannelParams* a, const ChannelParams* b) {
+    return a->snr_db == b->snr_db &&
+           a->noise_seed == b->noise_seed &&
+           a->multipath == b->multipath &&
+           a->cfo_hz == b->cfo_hz &&
+           a->phase_noise_deg == b->phase_noise_deg &&
+           a->phase_noise_bandwidth == b->phase_noise_bandwidth &&
+           a->dc_offset == b->dc_offset &&
+           a->iq_gain_db == b->iq_gain_db &&
+           a->iq_phase_deg == b->iq_phase_deg &&
+           a->fading == b->fading &&
+           a->doppler_hz == b->doppler_hz &&
+           a->rician_k_db == b->rician_k_db;
+}
+
+bool channel_is_clean(const Channel* channel) {
+    return !channel->filtered && channel->dc_I == 0.0 && channel->dc_Q == 0.0 && channel->noise_std_dev <= 0.0;
+}
+
+double channel_signal_power(const Channel* channel) {
+    return channel->signal_power;
+}
+
+// Outputs per overlap-save transform
+static int block_step(const Channel* channel) {
+    return channel->fft_size - channel->filter_length + 1;
+}
+
+// The transforms sit on a fixed grid of sample indices, so a sample always
+// goes through the same transform with the same neighbours and comes out
+// bit-identical however the signal is split up. That costs up to a block of
+// extra input on either side of a call.
+int channel_history(const Channel* channel) {
+    return channel->filtered ? channel->history + block_step(channel) - 1 : 0;
+}
+
+int channel_lookahead(const Channel* channel) {
+    return channel->filtered ? channel->lookahead + block_step(channel) - 1 : 0;
+}
+
+// Overlap-save: each transform of fft_size input samples yields
+// fft_size - filter_length + 1 outputs of the analytic signal, which are
+// rotated and passed through the front end straight into 'out'. The
+// buffers are left in 'workspace' for the caller to release.
+static bool filter_block(const Channel* channel, int64_t first, const double* in, double* out, int n, Workspace* workspace) {
+    const int N = channel->fft_size;
+    const int M = channel->filter_length;
+    const int step = block_step(channel);
+
+    // Split real and imaginary halves of one allocation each
+    double* buffer = workspace_doubles(workspace, 2 * (size_t)N);
+    double* faded = channel->fading_taps != NULL ? workspace_doubles(workspace, 2 * (size_t)step) : NULL;
+    if (buffer == NULL || (channel->fading_taps != NULL && faded == NULL)) return false;
+    double* buffer_real = buffer;
+    double* buffer_imag = buffer + N;
+
+    PhaseNoise pn = {0};
+    if (channel->phase_noise_length > 0 &&
+        !phase_noise_start(&pn, channel->phase_noise_length, channel->phase_noise_step, channel->params.noise_seed, first,
+                           workspace)) return false;
+
+    // Offset of the first output within its block
+    int skip = (int)(first % step);
+    if (skip < 0) skip += step;
+
+    for (int at = -skip; at < n; at += step) {
+        int begin = at < 0 ? 0 : at;
+        int end = at + step < n ? at + step : n;
+
+        // Input from sample first + at - history on
+        // The block is real, so its spectrum is Hermitian: transform half
+        // and mirror the rest, since the filter isn't
+        const double* block_in = in + at - channel->history;
+        fft_real_forward(channel->real_plan, block_in, buffer_real, buffer_imag);
+        for (int k = 1; k < N / 2; ++k) {
+            buffer_real[N - k] = buffer_real[k];
+            buffer_imag[N - k] = -buffer_imag[k];
+        }
+        for (int k = 0; k < N; ++k) {
+            double re = buffer_real[k] * channel->filter_real[k] - buffer_imag[k] * channel->filter_imag[k];
+            double im = buffer_real[k] * channel->filter_imag[k] + buffer_imag[k] * channel->filter_real[k];
+            buffer_real[k] = re;
+            buffer_imag[k] = im;
+        }
+        fft_inverse(channel->plan, buffer_real, buffer_imag);
+
+        const double* z_real = buffer_real + M - 1 - at;
+        const double* z_imag = buffer_imag + M - 1 - at;
+        if (faded != NULL) {
+            int64_t started = thread_nanoseconds();
+            fading_apply(channel, first + begin, z_real + begin, z_imag + begin, faded, faded + step, end - begin);
+            __atomic_fetch_add(&channel->counters->nanoseconds, thread_nanoseconds() - started, __ATOMIC_RELAXED);
+            z_real = faded - begin;
+            z_imag = faded + step - begin;
+        }
+        for (int i = begin; i < end; ++i) {
+            uint64_t index = (uint64_t)(first + i);
+            uint32_t phase = (uint32_t)(index * channel->cfo_increment);
+            if (channel->phase_noise_length > 0) {
+                phase += (uint32_t)(int64_t)llrint(phase_noise_next(&pn) * channel->phase_noise_scale);
+            }
+            double c = nco_cos(phase, NCO_PRECISION_INTERP_LUT);
+            double s = nco_sin(phase, NCO_PRECISION_INTERP_LUT);
+            double re = z_real[i] * c - z_imag[i] * s;
+            double im = z_real[i] * s + z_imag[i] * c;
+
+            double y = channel->mu_real * re - channel->mu_imag * im;
+            if (channel->imbalanced) {
+                // Re{nu * conj(z) * e^(j 2 carrier)}: the image about the carrier
+                uint32_t image_phase = (uint32_t)(index * channel->carrier_increment * 2u);
+                double image_re = channel->nu_real * re + channel->nu_imag * im;
+                double image_im = channel->nu_imag * re - channel->nu_real * im;
+                y += image_re * nco_cos(image_phase, NCO_PRECISION_INTERP_LUT) -
+                     image_im * nco_sin(image_phase, NCO_PRECISION_INTERP_LUT);
+            }
+            out[i] = y;
+        }
+    }
+    return true;
+}
+
+bool channel_process(const Channel* channel, int64_t first, const double* in, double* out, int n, Workspace* workspace) {
+    if (n <= 0) return true;
+
+    if (channel->filtered) {
+        Workspace local = {0};
+        Workspace* scratch = workspace != NULL ? workspace : &local;
+        size_t mark = workspace_mark(scratch);
+        bool ok = filter_block(channel, first, in, out, n, scratch);
+        workspace_release(scratch, mark);
+        workspace_free(&local);
+        if (!ok) return false;
+    } else if (out != in) {
+        memcpy(out, in, n * sizeof(double));
+    }
+
+    // DC on I and Q, carried up to the carrier like the rest of the front end
+    if (channel->dc_I != 0.0 || channel->dc_Q != 0.0) {
+        for (int i = 0; i < n; ++i) {
+            uint32_t phase = (uint32_t)((uint64_t)(first + i) * channel->carrier_increment);
+            out[i] += channel->dc_I * nco_cos(phase, NCO_PRECISION_INTERP_LUT) -
+                      channel->dc_Q * nco_sin(phase, NCO_PRECISION_INTERP_LUT);
+        }
+    }
+
+    if (channel->noise_std_dev > 0.0) {
+        noise_add(channel->params.noise_seed, NOISE_STREAM_SIGNAL, first, out, n, channel->noise_std_dev);
+    }
+    return true;
+}
+
+FadingStats channel_fading_stats(const Channel* channel) {
+    FadingStats stats;
+    stats.samples = __atomic_load_n(&channel->counters->samples, __ATOMIC_RELAXED);
+    stats.gain_updates = __atomic_load_n(&channel->counters->gain_updates, __ATOMIC_RELAXED);
+    stats.seconds = __atomic_load_n(&channel->counters->nanoseconds, __ATOMIC_RELAXED) * 1e-9;
+    return stats;
+}
+
+const char* fading_model_name(FadingModel model) {
+    switch (model) {
+        case FADING_RAYLEIGH: return "rayleigh";
+        case FADING_RICIAN: return "rician";
+        default: return "none";
+    }
+}
+
+const char* multipath_profile_name(MultipathProfile profile) {
+    if (profile < MULTIPATH_NONE || profile > MULTIPATH_DENSE) return "none";
+    return multipath_profiles[profile].name;
+}
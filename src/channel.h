@@ -0,0 +1,125 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "workspace.h"
+
+// What happens to the signal between the modulator and everything that
+// reads it: the views, the export and sigviz-gen all see the channel's
+// output rather than adding impairments of their own. The IQ view gets
+// its points by downconverting that output, not from the symbols.
+//
+// The signal is real and at passband, so the impairments that belong to
+// the complex envelope (multipath with complex path gains, frequency
+// offset, phase noise, IQ imbalance, DC) are applied to its analytic
+// signal, taken with a Hilbert FIR. That FIR and the multipath taps are
+// one filter, run by FFT overlap-save. IQ imbalance and DC are those of a
+// quadrature front end with its LO at the carrier, so DC shows up as
+// carrier leakage. AWGN is added last.
+//
+// With fading on, the multipath profile becomes a tapped delay line whose
+// taps vary in time instead of one fixed filter: the overlap-save filter
+// is then the Hilbert FIR alone and each tap's gain is a sum of sinusoids
+// with a Clarke/Jakes Doppler spectrum, evaluated on a grid of samples
+// and interpolated between.
+//
+// Phase noise is integer white noise through a triangular filter. Each
+// call starts that filter afresh from the noise before its first sample,
+// which costs up to 2 * 256 noise samples: a filter longer than 256 taps
+// (a narrow phase noise bandwidth) is run on a coarser grid of samples
+// and interpolated between, so the cost of a call stays in proportion to
+// its length rather than to the filter's.
+//
+// Every impairment is a function of the sample index: a block comes out
+// the same whichever way a signal is split between calls or threads.
+
+// Signal-to-noise ratios at or above this are noiseless
+#define CHANNEL_SNR_NOISELESS 100.0
+
+// Half length of the Hilbert FIR. Its 193 taps keep the analytic signal's
+// image below -60 dB from about 0.04 to 0.46 of the sampling rate.
+#define CHANNEL_HILBERT_HALF 96
+
+// That FIR, for receivers that take the analytic signal the same way:
+// taps[k] is its response at lag k for k = 0 to CHANNEL_HILBERT_HALF. It
+// is odd, so lag -k is -taps[k], and zero at the even lags.
+void channel_hilbert_taps(double* taps);
+
+// Longest phase noise filter, which keeps its integer sums within 64 bits
+#define CHANNEL_PHASE_NOISE_MAX_LENGTH 65536
+
+typedef enum {
+    MULTIPATH_NONE,
+    MULTIPATH_TWO_RAY,
+    MULTIPATH_THREE_RAY,
+    MULTIPATH_DENSE
+} MultipathProfile;
+
+#define MULTIPATH_PROFILE_COUNT (MULTIPATH_DENSE + 1)
+
+typedef enum {
+    FADING_NONE,
+    FADING_RAYLEIGH,
+    FADING_RICIAN  // line of sight on the first tap
+} FadingModel;
+
+#define FADING_MODEL_COUNT (FADING_RICIAN + 1)
+
+typedef struct {
+    double snr_db;
+    uint64_t noise_seed;
+    MultipathProfile multipath;
+    double cfo_hz;                // carrier frequency offset
+    double phase_noise_deg;       // rms
+    double phase_noise_bandwidth; // Hz, roughly where its spectrum falls off
+    double dc_offset;             // on I and Q, relative to the signal's rms
+    double iq_gain_db;            // Q branch gain relative to I
+    double iq_phase_deg;          // quadrature error
+    FadingModel fading;
+    double doppler_hz;            // maximum Doppler shift
+    double rician_k_db;           // line of sight to scattered power
+} ChannelParams;
+
+// Work done by the fading stage since the channel was built, summed over
+// every thread
+typedef struct {
+    int64_t samples;
+    int64_t gain_updates; // tap gains evaluated on the grid
+    double seconds;       // CPU time of the threads, not wall time
+} FadingStats;
+
+typedef struct Channel Channel;
+
+// Builds the channel for a signal at 'sampling_rate' with its carrier at
+// 'carrier_frequency' and 'samples_per_symbol' (multipath delays are in
+// symbol periods). Noise and DC are calibrated against 'signal_power', the
+// measured mean square of the clean signal (see modulator_signal_power).
+// NULL if an allocation failed.
+Channel* channel_create(const ChannelParams* params, double sampling_rate, double carrier_frequency,
+                        int samples_per_symbol, double signal_power);
+void channel_destroy(Channel* channel);
+
+bool channel_params_equal(const ChannelParams* a, const ChannelParams* b);
+// True when the channel leaves the signal untouched, so callers can skip it
+bool channel_is_clean(const Channel* channel);
+double channel_signal_power(const Channel* channel);
+
+// Input samples an output block needs before and after its own span
+int channel_history(const Channel* channel);
+int channel_lookahead(const Channel* channel);
+
+// Produces output samples [first, first + n) into 'out'. 'in' points at
+// input sample 'first' and must be readable from in[-history] up to
+// in[n + lookahead - 1]. 'in' and 'out' may be the same buffer when both
+// margins are 0. The filter's scratch comes from 'workspace' and is
+// released before returning; NULL allocates it for the call. False if an
+// allocation failed.
+bool channel_process(const Channel* channel, int64_t first, const double* in, double* out, int n, Workspace* workspace);
+
+FadingStats channel_fading_stats(const Channel* channel);
+
+const char* multipath_profile_name(MultipathProfile profile);
+const char* fading_model_name(FadingModel model);
+
+#endif // CHANNEL_H
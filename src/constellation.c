@@ -0,0 +1,182 @@
+#include "constellation.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define MODULATION_COUNT (MOD_APSK + 1)
+
+static Constellation* tables[MODULATION_COUNT][CONSTELLATION_MAX_BITS + 1];
+
+static int gray_encode(int k) {
+    return k ^ (k >> 1);
+}
+
+// Evenly spaced levels from -1 to 1, indexed by their Gray label
+static void gray_levels(double* levels, int bits) {
+    int count = 1 << bits;
+    for (int k = 0; k < count; ++k) {
+        levels[gray_encode(k)] = (count == 1) ? 0.0 : (2.0 * k - (count - 1)) / (count - 1);
+    }
+}
+
+static void build_ask(Constellation* c) {
+    for (int k = 0; k < c->order; ++k) {
+        c->I[gray_encode(k)] = (double)k / (c->order - 1);
+        c->Q[gray_encode(k)] = 0.0;
+    }
+}
+
+// cos and sin of a multiple of pi/2 are off zero by an ulp of pi; snapped
+// back, so BPSK's Q is exactly 0 and it takes the real path
+static double snap_to_axis(double x) {
+    return fabs(x) < 1e-12 ? 0.0 : x;
+}
+
+static void build_psk(Constellation* c) {
+    double offset = (c->order == 4) ? M_PI / 4.0 : 0.0;
+    for (int k = 0; k < c->order; ++k) {
+        double angle = (2.0 * M_PI * k) / c->order + offset;
+        c->I[gray_encode(k)] = snap_to_axis(cos(angle));
+        c->Q[gray_encode(k)] = snap_to_axis(sin(angle));
+    }
+}
+
+static void build_fsk(Constellation* c) {
+    for (int v = 0; v < c->order; ++v) {
+        double angle = (2.0 * M_PI * v) / c->order;
+        c->I[v] = cos(angle);
+        c->Q[v] = sin(angle);
+    }
+}
+
+// Rectangular QAM: the high bits pick the I level and the low bits the Q
+// level, each Gray-coded, so an odd order gets twice as many I levels
+static bool build_qam(Constellation* c) {
+    int q_bits = c->bits_per_symbol / 2;
+    int i_bits = c->bits_per_symbol - q_bits;
+    double* i_levels = (double*)malloc(((size_t)1 << i_bits) * sizeof(double));
+    double* q_levels = (double*)malloc(((size_t)1 << q_bits) * sizeof(double));
+    if (i_levels == NULL || q_levels == NULL) {
+        free(i_levels);
+        free(q_levels);
+        return false;
+    }
+    gray_levels(i_levels, i_bits);
+    gray_levels(q_levels, q_bits);
+
+    // Scale so the corner points sit on the unit circle
+    double corner = sqrt(1.0 + (q_bits > 0 ? 1.0 : 0.0));
+    for (int v = 0; v < c->order; ++v) {
+        c->I[v] = i_levels[v >> q_bits] / corner;
+        c->Q[v] = q_levels[v & ((1 << q_bits) - 1)] / corner;
+    }
+    free(i_levels);
+    free(q_levels);
+    return true;
+}
+
+// Concentric rings as in DVB-S2, with the rate 3/4 ring ratios. Each ring,
+// outermost first, takes both ends of what is left of the binary-reflected
+// Gray sequence, in angle order. Positions k and order - 1 - k differ only
+// in the top bit, so the two ends join up: every neighbour on a ring is one
+// bit away, across the wrap too. Neighbours on different rings are not.
+static bool build_apsk(Constellation* c) {
+    static const int ring_points_16[] = { 4, 12 };
+    static const double ring_radius_16[] = { 1.0 / 2.85, 1.0 };
+    static const int ring_points_32[] = { 4, 12, 16 };
+    static const double ring_radius_32[] = { 1.0 / 5.27, 2.84 / 5.27, 1.0 };
+
+    const int* ring_points;
+    const double* ring_radius;
+    int rings;
+    if (c->bits_per_symbol == 4) {
+        ring_points = ring_points_16;
+        ring_radius = ring_radius_16;
+        rings = 2;
+    } else if (c->bits_per_symbol == 5) {
+        ring_points = ring_points_32;
+        ring_radius = ring_radius_32;
+        rings = 3;
+    } else {
+        return false;
+    }
+
+    int low = 0, high = c->order - 1;
+    for (int r = rings - 1; r >= 0; --r) {
+        int half = ring_points[r] / 2;
+        // Rotate each ring by half a point spacing, as QPSK is by pi/4
+        double offset = M_PI / ring_points[r];
+        for (int p = 0; p < ring_points[r]; ++p) {
+            int k = p < half ? low + p : high - (ring_points[r] - 1 - p);
+            double angle = (2.0 * M_PI * p) / ring_points[r] + offset;
+            c->I[gray_encode(k)] = ring_radius[r] * cos(angle);
+            c->Q[gray_encode(k)] = ring_radius[r] * sin(angle);
+        }
+        low += half;
+        high -= half;
+    }
+    return true;
+}
+
+const Constellation* constellation_get(ModulationType type, int bits_per_symbol) {
+    if ((int)type < 0 || type >= MODULATION_COUNT) return NULL;
+    if (bits_per_symbol < 1 || bits_per_symbol > CONSTELLATION_MAX_BITS) return NULL;
+    if (tables[type][bits_per_symbol] != NULL) return tables[type][bits_per_symbol];
+    if (type == MOD_APSK && (bits_per_symbol < CONSTELLATION_APSK_MIN_BITS || bits_per_symbol > CONSTELLATION_APSK_MAX_BITS)) {
+        return NULL;
+    }
+
+    Constellation* c = (Constellation*)calloc(1, sizeof(Constellation));
+    if (c == NULL) return NULL;
+    c->type = type;
+    c->bits_per_symbol = bits_per_symbol;
+    c->order = 1 << bits_per_symbol;
+    c->I = (double*)malloc(c->order * sizeof(double));
+    c->Q = (double*)malloc(c->order * sizeof(double));
+    bool ok = c->I != NULL && c->Q != NULL;
+
+    if (ok) {
+        switch (type) {
+            case MOD_ASK: build_ask(c); break;
+            case MOD_FSK: build_fsk(c); break;
+            case MOD_PSK: build_psk(c); break;
+            case MOD_QAM: ok = build_qam(c); break;
+            case MOD_APSK: ok = build_apsk(c); break;
+        }
+    }
+    if (!ok) {
+        free(c->I);
+        free(c->Q);
+        free(c);
+        return NULL;
+    }
+
+    c->is_complex = false;
+    for (int v = 0; v < c->order; ++v) {
+        if (c->Q[v] != 0.0) c->is_complex = true;
+    }
+    tables[type][bits_per_symbol] = c;
+    return c;
+}
+
+void constellation_free_tables(void) {
+    for (int t = 0; t < MODULATION_COUNT; ++t) {
+        for (int b = 0; b <= CONSTELLATION_MAX_BITS; ++b) {
+            if (tables[t][b] == NULL) continue;
+            free(tables[t][b]->I);
+            free(tables[t][b]->Q);
+            free(tables[t][b]);
+            tables[t][b] = NULL;
+        }
+    }
+}
+
+const char* modulation_name(ModulationType type) {
+    switch (type) {
+        case MOD_ASK: return "ASK";
+        case MOD_FSK: return "FSK";
+        case MOD_PSK: return "PSK";
+        case MOD_QAM: return "QAM";
+        case MOD_APSK: return "APSK";
+    }
+    return "?";
+}
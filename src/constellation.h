@@ -0,0 +1,37 @@
+#ifndef CONSTELLATION_H
+#define CONSTELLATION_H
+
+#include "dsp_common.h"
+
+// APSK is defined for 16 (4+12) and 32 (4+12+16) points only
+#define CONSTELLATION_APSK_MIN_BITS 4
+#define CONSTELLATION_APSK_MAX_BITS 5
+#define CONSTELLATION_MAX_BITS 16
+
+// The I/Q point of every symbol value for one scheme and order, built once
+// so the modulator and the IQ plot look symbols up instead of calling
+// cos/sin. Points are Gray-coded: neighbouring points differ in one bit,
+// except across APSK rings, each of which is a Gray cycle of its own. The
+// peak magnitude is 1, except ASK, whose levels run from 0 to 1 on the I
+// axis.
+//
+// FSK has no constellation of its own; its table places the tones around
+// the unit circle in natural order, which is how the IQ plot shows them.
+typedef struct {
+    ModulationType type;
+    int bits_per_symbol;
+    int order;
+    double* I;
+    double* Q;
+    bool is_complex; // false when every Q is zero
+} Constellation;
+
+// Returns the table for a scheme and order, building it on first use, or
+// NULL if the scheme has no constellation of that order. Tables stay valid
+// until constellation_free_tables().
+const Constellation* constellation_get(ModulationType type, int bits_per_symbol);
+void constellation_free_tables(void);
+
+const char* modulation_name(ModulationType type);
+
+#endif // CONSTELLATION_H
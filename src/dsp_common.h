@@ -0,0 +1,29 @@
+#ifndef DSP_COMMON_H
+#define DSP_COMMON_H
+
+// The parts of shared.h the signal generation code needs, kept free of SDL
+// so the same sources build into the headless generator.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef enum { MOD_ASK, MOD_FSK, MOD_PSK, MOD_QAM, MOD_APSK } ModulationType;
+typedef enum { WINDOW_HANN, WINDOW_HAMMING, WINDOW_RECTANGULAR } WindowType;
+
+// --- Shared Helper Function Prototypes ---
+int get_symbol_at_index(int64_t symbol_index, const char* message, int64_t message_len, int bits_per_sym);
+double sinc(double x);
+double raised_cosine(double t, double T_s, double beta);
+
+// 'bytes' aligned to 'alignment' (a power of two, at least the size of a
+// pointer), released only with aligned_buffer_free. NULL if the allocation
+// fails.
+void* aligned_buffer_alloc(size_t alignment, size_t bytes);
+void aligned_buffer_free(void* buffer);
+
+#endif // DSP_COMMON_H
@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <limits.h>
+#include "parallel.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -12,106 +14,108 @@ extern void downloadFile(const void* data, int dataSize, const char* filename);
 #include "tinyfiledialogs.h"
 #endif
 
+// One chunk at the export rate, with the threads' scratch kept in
+// 'workspaces' from one chunk to the next
+static bool render_chunk(const Waveform* waveform, const Resampler* resampler, int64_t position, float* out, int count,
+                         WorkspaceSet* workspaces) {
+    if (resampler != NULL) {
+        return modulator_render_resampled_f32(&waveform->params, waveform->symbols, waveform->channel, resampler,
+                                              position, out, count, export_threads, workspaces);
+    }
+    return modulator_render_range_f32(&waveform->params, waveform->symbols, waveform->channel, position, out, count,
+                                      export_threads, workspaces);
+}
+
 void export_waveform(
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type)
+    const Waveform* waveform)
 {
-    if (activeMessageLength == 0) {
+    if (waveform->symbols == NULL || waveform->symbols->count == 0) {
         printf("No active message to export.\n");
         return;
     }
 
-    double symbol_period_seconds = (double)pixelsPerBit / sampling_rate;
-    int total_symbols = (activeMessageLength * 8) / bitsPerSymbol;
-    if (total_symbols == 0 && activeMessageLength > 0) total_symbols = 1;
-    int total_samples = (int)(total_symbols * symbol_period_seconds * sampling_rate);
-
+    int64_t total_samples = modulator_total_samples(&waveform->params, waveform->symbols);
     if (total_samples <= 0) {
         printf("No samples to export.\n");
         return;
     }
 
+    // The waveform is generated at a whole number of samples per symbol
+    // and resampled to the export rate, if one is set
+    Resampler* resampler = NULL;
+    if (export_rate > 0.0 && export_rate != waveform->params.sampling_rate) {
+        resampler = resampler_create(waveform->params.sampling_rate, export_rate);
+        if (resampler == NULL) {
+            printf("Failed to set up resampling to %.f Hz.\n", export_rate);
+            return;
+        }
+        total_samples = resampler_output_length(resampler, total_samples);
+    }
+
+#ifdef __EMSCRIPTEN__
+    // The download is handed over as one buffer
+    if (total_samples > INT_MAX / (int)sizeof(float)) {
+        printf("Waveform of %lld samples is too large to download.\n", (long long)total_samples);
+        resampler_destroy(resampler);
+        return;
+    }
+
     float* waveform_data = (float*)malloc(total_samples * sizeof(float));
     if (waveform_data == NULL) {
         printf("Failed to allocate memory for waveform data.\n");
+        resampler_destroy(resampler);
         return;
     }
 
-    double phase = 0.0;
-
-    for (int i = 0; i < total_samples; i++) {
-        double current_time = (double)i / sampling_rate;
-        double y = 0.0;
-
-        switch (current_mod_type) {
-            case MOD_ASK: {
-                double shaped_envelope = 0.0;
-                int M = 1 << bitsPerSymbol;
-                int current_symbol_index = (int)(current_time / symbol_period_seconds);
-                for (int j = -4; j <= 4; ++j) {
-                    int symbol_index = current_symbol_index + j;
-                    if (symbol_index < 0 || symbol_index >= total_symbols) continue;
-                    int symbol_value = get_symbol_at_index(symbol_index, activeMessage, activeMessageLength, bitsPerSymbol);
-                    double impulse_value = (M == 1) ? symbol_value : (double)symbol_value / (M - 1);
-                    double symbol_center_time = (symbol_index + 0.5) * symbol_period_seconds;
-                    double time_from_center = current_time - symbol_center_time;
-                    double filter_kernel_value = raised_cosine(time_from_center, symbol_period_seconds, rolloff_factor);
-                    shaped_envelope += impulse_value * filter_kernel_value;
-                }
-                double current_amplitude = amplitude * shaped_envelope;
-                y = current_amplitude * sin(2.0 * M_PI * frequency * current_time);
-                break;
-            }
-            case MOD_FSK: {
-                int symbol_index = (int)(current_time / symbol_period_seconds);
-                if (symbol_index >= total_symbols) symbol_index = total_symbols - 1;
-                int symbol_value = get_symbol_at_index(symbol_index, activeMessage, activeMessageLength, bitsPerSymbol);
-                double frequency_separation = frequency / 2.0;
-                double current_freq = frequency + (symbol_value * frequency_separation);
-                double phase_increment = 2.0 * M_PI * current_freq / sampling_rate;
-                phase += phase_increment;
-                y = amplitude * sin(phase);
-                break;
-            }
-            case MOD_PSK: {
-                double shaped_I = 0.0, shaped_Q = 0.0;
-                int M = 1 << bitsPerSymbol;
-                int current_symbol_index = (int)(current_time / symbol_period_seconds);
-                for (int j = -4; j <= 4; ++j) {
-                    int symbol_index = current_symbol_index + j;
-                    if (symbol_index < 0 || symbol_index >= total_symbols) continue;
-                    int symbol_value = get_symbol_at_index(symbol_index, activeMessage, activeMessageLength, bitsPerSymbol);
-                    double angle = (2.0 * M_PI * symbol_value) / M;
-                    if (M == 4) angle += M_PI / 4.0;
-                    double impulse_I = cos(angle);
-                    double impulse_Q = sin(angle);
-                    double symbol_center_time = (symbol_index + 0.5) * symbol_period_seconds;
-                    double time_from_center = current_time - symbol_center_time;
-                    double filter_kernel_value = raised_cosine(time_from_center, symbol_period_seconds, rolloff_factor);
-                    shaped_I += impulse_I * filter_kernel_value;
-                    shaped_Q += impulse_Q * filter_kernel_value;
-                }
-                double carrier_phase = 2.0 * M_PI * frequency * current_time;
-                y = amplitude * (shaped_I * cos(carrier_phase) - shaped_Q * sin(carrier_phase));
-                break;
-            }
-        }
-        waveform_data[i] = (float)y;
+    if (!render_chunk(waveform, resampler, 0, waveform_data, (int)total_samples, NULL)) {
+        printf("Failed to allocate the modulators for export.\n");
+        free(waveform_data);
+        resampler_destroy(resampler);
+        return;
     }
-
-#ifdef __EMSCRIPTEN__
-    downloadFile(waveform_data, total_samples * sizeof(float), "waveform.32fl");
+    downloadFile(waveform_data, (int)(total_samples * sizeof(float)), "waveform.32fl");
+    free(waveform_data);
+    resampler_destroy(resampler);
 #else
     char const * filterPatterns[1] = { "*.32fl" };
     char const * saveFileName = tinyfd_saveFileDialog("Save Waveform", "waveform.32fl", 1, filterPatterns, "32-bit Float Waveform");
-    if (saveFileName) {
-        FILE* outFile = fopen(saveFileName, "wb");
-        if (outFile) {
-            fwrite(waveform_data, sizeof(float), total_samples, outFile);
-            fclose(outFile);
+    FILE* outFile = saveFileName != NULL ? fopen(saveFileName, "wb") : NULL;
+    if (!outFile) {
+        if (saveFileName != NULL) printf("Failed to open '%s' for writing.\n", saveFileName);
+        resampler_destroy(resampler);
+        return;
+    }
+
+    // Render straight to float in chunks, each split across the export
+    // threads, so the file can be far larger than memory. The chunk is
+    // allocated per export rather than taken from the frame workspace,
+    // which would otherwise keep it for good.
+    int chunk_samples = EXPORT_CHUNK_SAMPLES * parallel_thread_count(export_threads);
+    if (chunk_samples > total_samples) chunk_samples = (int)total_samples;
+    float* waveform_data = (float*)malloc(chunk_samples * sizeof(float));
+    if (waveform_data == NULL) {
+        printf("Failed to allocate memory for waveform data.\n");
+        fclose(outFile);
+        resampler_destroy(resampler);
+        return;
+    }
+
+    WorkspaceSet workspaces = {0};
+    for (int64_t position = 0; position < total_samples; position += chunk_samples) {
+        int count = total_samples - position < chunk_samples ? (int)(total_samples - position) : chunk_samples;
+        // The exported file carries the same channel as the views
+        if (!render_chunk(waveform, resampler, position, waveform_data, count, &workspaces)) {
+            printf("Failed to allocate the modulators for export.\n");
+            break;
+        }
+        if (fwrite(waveform_data, sizeof(float), count, outFile) != (size_t)count) {
+            printf("Failed to write '%s'.\n", saveFileName);
+            break;
         }
     }
-#endif
+    fclose(outFile);
+    workspace_set_free(&workspaces);
     free(waveform_data);
-}
\ No newline at end of file
+    resampler_destroy(resampler);
+#endif
+}
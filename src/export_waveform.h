@@ -2,11 +2,13 @@
 #define EXPORT_WAVEFORM_H
 
 #include "shared.h"
+#include "modulator.h"
+
+// Samples each export thread renders per chunk written to disk
+#define EXPORT_CHUNK_SAMPLES 262144
 
 void export_waveform(
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type
+    const Waveform* waveform
 );
 
 #endif // EXPORT_WAVEFORM_H
\ No newline at end of file
@@ -1,179 +1,104 @@
 #include "fft.h"
 #include "shared.h"
+#include "welch.h"
 #include <math.h>
 #include <stdlib.h>
 
-// A simple structure to hold a complex number
-typedef struct {
-    double real;
-    double imag;
-} Complex;
-
-// Swaps two complex numbers (can be static as it's only used here)
-static void swap_complex(Complex* a, Complex* b) {
-    Complex temp = *a;
-    *a = *b;
-    *b = temp;
+// Segments averaged over the whole message; a long payload has them
+// spread evenly through it instead of every one transformed
+#define SPECTRUM_MESSAGE_SEGMENTS 256
+
+// The spectrum runs every frame, so the estimator and the density are
+// kept and only rebuilt when the size, window or averaging change; the
+// rest is scratch from the frame workspace
+static Welch* spectrum_welch = NULL;
+static WelchParams spectrum_params;
+static double* spectrum_density = NULL; // one-sided PSD, bins 0 to fft_size / 2
+// The waveform generation spectrum_density was averaged over in
+// SPECTRUM_AVERAGE_MESSAGE, so the message is only gone over again when
+// the signal changes
+static int64_t message_generation = -1;
+// The render threads' scratch for SPECTRUM_AVERAGE_MESSAGE
+static WorkspaceSet spectrum_workspaces = {0};
+
+void spectrum_free_cache(void) {
+    welch_destroy(spectrum_welch);
+    spectrum_welch = NULL;
+    free(spectrum_density);
+    spectrum_density = NULL;
+    message_generation = -1;
+    workspace_set_free(&spectrum_workspaces);
 }
 
-// The Radix-2 Cooley-Tukey FFT algorithm
-static void fft(Complex* x, int N) {
-    if (N <= 1) return;
-
-    // Bit-Reversal Permutation
-    int j = 0;
-    for (int i = 1; i < N; i++) {
-        int bit = N >> 1;
-        while (j >= bit) {
-            j -= bit;
-            bit >>= 1;
-        }
-        j += bit;
-        if (i < j) {
-            swap_complex(&x[i], &x[j]);
-        }
-    }
-
-    // Cooley-Tukey Algorithm
-    for (int len = 2; len <= N; len <<= 1) {
-        double angle = -2.0 * M_PI / len;
-        Complex wlen = {cos(angle), sin(angle)};
-        for (int i = 0; i < N; i += len) {
-            Complex w = {1.0, 0.0};
-            for (j = 0; j < len / 2; j++) {
-                Complex u = x[i + j];
-                Complex v = {x[i + j + len / 2].real * w.real - x[i + j + len / 2].imag * w.imag,
-                             x[i + j + len / 2].real * w.imag + x[i + j + len / 2].imag * w.real};
-                x[i + j].real = u.real + v.real;
-                x[i + j].imag = u.imag + v.imag;
-                x[i + j + len / 2].real = u.real - v.real;
-                x[i + j + len / 2].imag = u.imag - v.imag;
-                double w_real_temp = w.real * wlen.real - w.imag * wlen.imag;
-                w.imag = w.real * wlen.imag + w.imag * wlen.real;
-                w.real = w_real_temp;
-            }
+static bool prepare_spectrum(WindowType window_type) {
+    WelchParams params;
+    params.segment_size = fft_size;
+    params.overlap = spectrum_overlap;
+    params.max_segments = spectrum_averaging == SPECTRUM_AVERAGE_MESSAGE ? SPECTRUM_MESSAGE_SEGMENTS : 0;
+    params.window = window_type;
+    params.sample_rate = sampling_rate;
+
+    if (spectrum_welch == NULL || spectrum_params.segment_size != params.segment_size ||
+        spectrum_params.overlap != params.overlap || spectrum_params.max_segments != params.max_segments ||
+        spectrum_params.window != params.window || spectrum_params.sample_rate != params.sample_rate) {
+        spectrum_free_cache();
+        spectrum_welch = welch_create(&params);
+        spectrum_density = (double*)malloc((fft_size / 2 + 1) * sizeof(double));
+        if (spectrum_welch == NULL || spectrum_density == NULL) {
+            spectrum_free_cache();
+            return false;
         }
+        spectrum_params = params;
     }
+    return true;
 }
 
 // Main function to calculate and draw the power spectrum
 void calculate_and_draw_spectrum(
     SDL_Renderer* renderer,
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type,
-    // Add the parameters here as well
+    Waveform* waveform,
     WindowType current_window_type,
     ViewMode current_view,
     int mouse_x)
 {
-    // 1. DYNAMIC MEMORY ALLOCATION
-    if ((fft_size & (fft_size - 1)) != 0 || fft_size == 0) {
-        return; // FFT size must be a power of 2
-    }
-    Complex* fft_buffer = (Complex*)malloc(fft_size * sizeof(Complex));
-    double* psd = (double*)malloc((fft_size / 2) * sizeof(double));
-
-    if (fft_buffer == NULL || psd == NULL) {
-        if (fft_buffer) free(fft_buffer);
-        if (psd) free(psd);
-        return;
-    }
-
-    // 2. Generate the signal data to be transformed
-    if (activeMessageLength > 0) {
-        double phase = 0.0;
-        double symbol_period_seconds = (double)pixelsPerBit / sampling_rate;
-        int total_symbols = (activeMessageLength * 8) / bitsPerSymbol;
-
-        for (int i = 0; i < fft_size; ++i) {
-            double current_time = time_offset + (double)i / sampling_rate;
-            double y = 0.0;
-
-            switch (current_mod_type) {
-                case MOD_ASK: {
-                    double shaped_envelope = 0.0;
-                    int M = 1 << bitsPerSymbol;
-                    int current_symbol_index = (int)(current_time / symbol_period_seconds);
-                    for (int j = -4; j <= 4; ++j) {
-                        int symbol_index = current_symbol_index + j;
-                        if (symbol_index < 0) continue;
-                        int symbol_value = get_symbol_at_index(symbol_index % total_symbols, activeMessage, activeMessageLength, bitsPerSymbol);
-                        double impulse_value = (M == 1) ? symbol_value : (double)symbol_value / (M - 1);
-                        double symbol_center_time = (symbol_index + 0.5) * symbol_period_seconds;
-                        double time_from_center = current_time - symbol_center_time;
-                        double filter_kernel_value = raised_cosine(time_from_center, symbol_period_seconds, rolloff_factor);
-                        shaped_envelope += impulse_value * filter_kernel_value;
-                    }
-                    double current_amplitude = amplitude * shaped_envelope;
-                    y = current_amplitude * sin(2.0 * M_PI * frequency * current_time);
-                    break;
-                }
-                case MOD_FSK: {
-                    int symbol_index = (int)(current_time / symbol_period_seconds);
-                    int symbol_value = get_symbol_at_index(symbol_index % total_symbols, activeMessage, activeMessageLength, bitsPerSymbol);
-                    double frequency_separation = frequency / 2.0;
-                    double current_freq = frequency + (symbol_value * frequency_separation);
-                    double phase_increment = 2.0 * M_PI * current_freq / sampling_rate;
-                    phase += phase_increment;
-                    y = amplitude * sin(phase);
-                    break;
-                }
-                case MOD_PSK: {
-                    double shaped_I = 0.0, shaped_Q = 0.0;
-                    int M = 1 << bitsPerSymbol;
-                    int current_symbol_index = (int)(current_time / symbol_period_seconds);
-                    for (int j = -4; j <= 4; ++j) {
-                        int symbol_index = current_symbol_index + j;
-                        if (symbol_index < 0) continue;
-                        int symbol_value = get_symbol_at_index(symbol_index % total_symbols, activeMessage, activeMessageLength, bitsPerSymbol);
-                        double angle = (2.0 * M_PI * symbol_value) / M;
-                        if (M == 4) angle += M_PI / 4.0;
-                        double impulse_I = cos(angle);
-                        double impulse_Q = sin(angle);
-                        double symbol_center_time = (symbol_index + 0.5) * symbol_period_seconds;
-                        double time_from_center = current_time - symbol_center_time;
-                        double filter_kernel_value = raised_cosine(time_from_center, symbol_period_seconds, rolloff_factor);
-                        shaped_I += impulse_I * filter_kernel_value;
-                        shaped_Q += impulse_Q * filter_kernel_value;
-                    }
-                    double carrier_phase = 2.0 * M_PI * frequency * current_time;
-                    y = amplitude * (shaped_I * cos(carrier_phase) - shaped_Q * sin(carrier_phase));
-                    break;
-                }
-            }
-            
-            fft_buffer[i].real = y;
-            fft_buffer[i].imag = 0.0;
-
-            double window_value = 1.0;
-            if (current_window_type == WINDOW_HANN) {
-                window_value = 0.5 * (1 - cos(2 * M_PI * i / (fft_size - 1)));
-            } else if (current_window_type == WINDOW_HAMMING) {
-                window_value = 0.54 - 0.46 * cos(2 * M_PI * i / (fft_size - 1));
-            }
-            fft_buffer[i].real *= window_value;
+    // 1. Estimator for this size (a power of 2), window and averaging
+    if (!prepare_spectrum(current_window_type)) return;
+
+    // 2. Average the periodograms of the segments, through the channel
+    if (spectrum_averaging == SPECTRUM_AVERAGE_MESSAGE) {
+        if (message_generation != waveform->generation) {
+            if (waveform->modulator == NULL ||
+                !modulator_power_spectrum(&waveform->params, waveform->symbols, waveform->channel, NULL, spectrum_welch,
+                                          0, waveform->total_samples, spectrum_density, 0,
+                                          &spectrum_workspaces)) return;
+            message_generation = waveform->generation;
         }
     } else {
-        for(int i = 0; i < fft_size; ++i) {
-            fft_buffer[i].real = 0.0;
-            fft_buffer[i].imag = 0.0;
+        // One segment, or spectrum_segments overlapping ones, from the
+        // view on, taken from the cached waveform
+        int segments = spectrum_averaging == SPECTRUM_SINGLE ? 1 : spectrum_segments;
+        int span = (int)welch_span(spectrum_welch, segments);
+        const double* samples = waveform_window(waveform, sample_clock, span, &frame_workspace);
+        if (samples != NULL) {
+            if (!welch_psd_samples(spectrum_welch, samples, span, spectrum_density, 0, &frame_workspace)) return;
+        } else {
+            for (int i = 0; i <= fft_size / 2; ++i) spectrum_density[i] = 0.0;
         }
+        message_generation = -1;
     }
 
-    // 3. Run the FFT
-    fft(fft_buffer, fft_size);
-
-    // 4. Calculate the Power Spectral Density (PSD) in dB
+    // 3. The density in dB
+    double* psd = workspace_doubles(&frame_workspace, fft_size / 2);
+    if (psd == NULL) return;
     for (int i = 0; i < fft_size / 2; ++i) {
-        double power = fft_buffer[i].real * fft_buffer[i].real + fft_buffer[i].imag * fft_buffer[i].imag;
+        double power = spectrum_density[i];
         if (spectrum_power > 1) {
             power = pow(power, spectrum_power);
         }
-        psd[i] = 10.0 * log10(power / fft_size + 1e-12);
+        psd[i] = 10.0 * log10(power + 1e-12);
     }
     
-    // 5. Draw the spectrum with hover detection
+    // 4. Draw the spectrum with hover detection
     double nyquist = sampling_rate / 2.0;
     double freq_per_bin = nyquist / (fft_size / 2.0);
 
@@ -216,8 +141,4 @@ void calculate_and_draw_spectrum(
         }
         SDL_RenderDrawLine(renderer, x_pos, SCREEN_HEIGHT - 50, x_pos, y_pos);
     }
-    
-    // 6. FREE DYNAMICALLY ALLOCATED MEMORY
-    free(fft_buffer);
-    free(psd);
 }
\ No newline at end of file
@@ -2,15 +2,22 @@
 #define FFT_H
 
 #include "shared.h"
+#include "modulator.h"
+
+// Range of the spectrum view's FFT size: a handful of bins up to segments
+// that still render in a frame
+#define SPECTRUM_MIN_FFT 16
+#define SPECTRUM_MAX_FFT (1 << 20)
 
 void calculate_and_draw_spectrum(
     SDL_Renderer* renderer,
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type,
+    Waveform* waveform,
     WindowType current_window_type,
     ViewMode current_view,
     int mouse_x
 );
 
+// Frees the Welch estimator and buffers kept between frames
+void spectrum_free_cache(void);
+
 #endif // FFT_H
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "fft_engine.h"
+#include "fft_kernels.h"
+#include "dsp_common.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Wide enough for a cache line and any vector width
+#define FFT_ALIGNMENT 64
+// The permutation moves tiles of 2^3 rows of 2^3 values, a cache line each
+#define FFT_TILE_BITS 3
+#define FFT_TILE (1 << FFT_TILE_BITS)
+
+double* fft_buffer_alloc(int count) {
+    size_t bytes = (size_t)(count > 0 ? count : 1) * sizeof(double);
+    bytes = (bytes + FFT_ALIGNMENT - 1) / FFT_ALIGNMENT * FFT_ALIGNMENT;
+    return (double*)aligned_buffer_alloc(FFT_ALIGNMENT, bytes);
+}
+
+// Quarter size of the first radix-4 pass: 2 after the radix-2 pass an
+// odd power of two starts with, otherwise 1
+static int first_quarter(int size) {
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+    return (bits & 1) ? 2 : 1;
+}
+
+FftPlan* fft_plan_create(int size) {
+    if (size < 1 || (size & (size - 1)) != 0) return NULL;
+    FftPlan* plan = (FftPlan*)calloc(1, sizeof(FftPlan));
+    if (plan == NULL) return NULL;
+    plan->size = size;
+    plan->bit_reverse = (int*)malloc(size * sizeof(int));
+    plan->twiddles = (Complex*)malloc((size / 2 > 0 ? size / 2 : 1) * sizeof(Complex));
+    if (plan->bit_reverse == NULL || plan->twiddles == NULL) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+    for (int i = 0; i < size; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        plan->bit_reverse[i] = reversed;
+    }
+
+    for (int k = 0; k < size / 2; ++k) {
+        double angle = -2.0 * M_PI * k / size;
+        plan->twiddles[k].real = cos(angle);
+        plan->twiddles[k].imag = sin(angle);
+    }
+
+    // A pass over blocks of 4q fuses the stages of size 2q and 4q, so it
+    // needs e^(-2 pi j k / 2q) and e^(-2 pi j k / 4q) for k < q
+    int total = 0;
+    for (int q = first_quarter(size); 4 * q <= size; q *= 4) total += 4 * q;
+    plan->pass_twiddles = fft_buffer_alloc(total);
+    if (plan->pass_twiddles == NULL) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+    double* w = plan->pass_twiddles;
+    for (int q = first_quarter(size); 4 * q <= size; q *= 4) {
+        for (int k = 0; k < q; ++k) {
+            double angle = -2.0 * M_PI * k / (4 * q);
+            w[k] = cos(2.0 * angle);
+            w[q + k] = sin(2.0 * angle);
+            w[2 * q + k] = cos(angle);
+            w[3 * q + k] = sin(angle);
+        }
+        w += 4 * q;
+    }
+    return plan;
+}
+
+void fft_plan_destroy(FftPlan* plan) {
+    if (plan == NULL) return;
+    free(plan->bit_reverse);
+    free(plan->twiddles);
+    aligned_buffer_free(plan->pass_twiddles);
+    free(plan);
+}
+
+// Reorders 'x' into bit-reversed order. Swapping element by element
+// touches a new cache line at every step, all of them mapping to the same
+// few cache sets, so larger sizes go tile by tile instead: with the index
+// split into high, middle and low bits, the tile of middle bits m swaps
+// with the tile of reversed m, transposed, and each row read or written
+// is a whole cache line.
+static void bit_reverse_permute(const FftPlan* plan, double* x) {
+    const int N = plan->size;
+    if (N < FFT_TILE * FFT_TILE * FFT_TILE) {
+        for (int i = 0; i < N; i++) {
+            int j = plan->bit_reverse[i];
+            if (i < j) {
+                double temp = x[i];
+                x[i] = x[j];
+                x[j] = temp;
+            }
+        }
+        return;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < N) bits++;
+    const int shift = bits - FFT_TILE_BITS;
+    const int tiles = N >> (2 * FFT_TILE_BITS);
+    int reverse[FFT_TILE]; // within a row
+    for (int i = 0; i < FFT_TILE; ++i) reverse[i] = plan->bit_reverse[i << shift];
+
+    double a[FFT_TILE * FFT_TILE], b[FFT_TILE * FFT_TILE];
+    for (int m = 0; m < tiles; ++m) {
+        int m_reversed = plan->bit_reverse[m << FFT_TILE_BITS] >> FFT_TILE_BITS;
+        if (m_reversed < m) continue;
+        double* tile_a = x + (m << FFT_TILE_BITS);
+        double* tile_b = x + (m_reversed << FFT_TILE_BITS);
+        for (int row = 0; row < FFT_TILE; ++row) {
+            for (int col = 0; col < FFT_TILE; ++col) {
+                a[row * FFT_TILE + col] = tile_a[((size_t)row << shift) + col];
+                b[row * FFT_TILE + col] = tile_b[((size_t)row << shift) + col];
+            }
+        }
+        for (int row = 0; row < FFT_TILE; ++row) {
+            for (int col = 0; col < FFT_TILE; ++col) {
+                int from = reverse[col] * FFT_TILE + reverse[row];
+                tile_b[((size_t)row << shift) + col] = a[from];
+                tile_a[((size_t)row << shift) + col] = b[from];
+            }
+        }
+    }
+}
+
+static void transform(const FftPlan* plan, double* real, double* imag) {
+    const int N = plan->size;
+    if (N <= 1) return;
+
+    bit_reverse_permute(plan, real);
+    bit_reverse_permute(plan, imag);
+
+    // An odd power of two starts with a radix-2 pass, whose twiddles are all 1
+    int quarter = first_quarter(N);
+    if (quarter == 2) {
+        for (int i = 0; i < N; i += 2) {
+            double a_real = real[i], a_imag = imag[i];
+            real[i] = a_real + real[i + 1];
+            imag[i] = a_imag + imag[i + 1];
+            real[i + 1] = a_real - real[i + 1];
+            imag[i + 1] = a_imag - imag[i + 1];
+        }
+    }
+
+    const FftKernels* kernels = fft_kernels_get();
+    const double* w = plan->pass_twiddles;
+    for (; 4 * quarter <= N; quarter *= 4) {
+        kernels->radix4(real, imag, N, quarter, w, w + quarter, w + 2 * quarter, w + 3 * quarter);
+        w += 4 * quarter;
+    }
+}
+
+void fft_forward(const FftPlan* plan, double* real, double* imag) {
+    transform(plan, real, imag);
+}
+
+// Swapping the real and imaginary parts conjugates and multiplies by j,
+// so doing it either side of the forward transform gives the inverse
+void fft_inverse(const FftPlan* plan, double* real, double* imag) {
+    transform(plan, imag, real);
+}
+
+// The Radix-2 Cooley-Tukey FFT algorithm; 'sign' is -1 for the forward
+// transform and +1 for the inverse, which conjugates the twiddles
+static void fft(const FftPlan* plan, Complex* x, double sign) {
+    const int N = plan->size;
+    if (N <= 1) return;
+
+    // Bit-Reversal Permutation
+    for (int i = 0; i < N; i++) {
+        int j = plan->bit_reverse[i];
+        if (i < j) {
+            Complex temp = x[i];
+            x[i] = x[j];
+            x[j] = temp;
+        }
+    }
+
+    // Cooley-Tukey Algorithm; stage 'len' uses every (N / len)th twiddle
+    const double conjugate = -sign;
+    for (int len = 2; len <= N; len <<= 1) {
+        int half = len / 2;
+        int stride = N / len;
+        for (int i = 0; i < N; i += len) {
+            for (int j = 0; j < half; j++) {
+                Complex w = plan->twiddles[j * stride];
+                w.imag *= conjugate;
+                Complex u = x[i + j];
+                Complex v = {x[i + j + half].real * w.real - x[i + j + half].imag * w.imag,
+                             x[i + j + half].real * w.imag + x[i + j + half].imag * w.real};
+                x[i + j].real = u.real + v.real;
+                x[i + j].imag = u.imag + v.imag;
+                x[i + j + half].real = u.real - v.real;
+                x[i + j + half].imag = u.imag - v.imag;
+            }
+        }
+    }
+}
+
+void fft_reference_forward(const FftPlan* plan, Complex* x) {
+    fft(plan, x, -1.0);
+}
+
+void fft_reference_inverse(const FftPlan* plan, Complex* x) {
+    fft(plan, x, 1.0);
+}
+
+FftRealPlan* fft_real_plan_create(int size) {
+    if (size < 2 || (size & (size - 1)) != 0) return NULL;
+    FftRealPlan* plan = (FftRealPlan*)calloc(1, sizeof(FftRealPlan));
+    if (plan == NULL) return NULL;
+    plan->size = size;
+    plan->half = fft_plan_create(size / 2);
+    plan->twiddles_real = fft_buffer_alloc(size / 2);
+    plan->twiddles_imag = fft_buffer_alloc(size / 2);
+    if (plan->half == NULL || plan->twiddles_real == NULL || plan->twiddles_imag == NULL) {
+        fft_real_plan_destroy(plan);
+        return NULL;
+    }
+    for (int k = 0; k < size / 2; ++k) {
+        double angle = -2.0 * M_PI * k / size;
+        plan->twiddles_real[k] = cos(angle);
+        plan->twiddles_imag[k] = sin(angle);
+    }
+    return plan;
+}
+
+void fft_real_plan_destroy(FftRealPlan* plan) {
+    if (plan == NULL) return;
+    fft_plan_destroy(plan->half);
+    aligned_buffer_free(plan->twiddles_real);
+    aligned_buffer_free(plan->twiddles_imag);
+    free(plan);
+}
+
+void fft_real_forward(const FftRealPlan* plan, const double* in, double* out_real, double* out_imag) {
+    const int H = plan->size / 2;
+    for (int n = 0; n < H; ++n) {
+        out_real[n] = in[2 * n];
+        out_imag[n] = in[2 * n + 1];
+    }
+    fft_forward(plan->half, out_real, out_imag);
+
+    // With Z the half-size transform, the even samples' spectrum is
+    // E[k] = (Z[k] + conj(Z[H-k])) / 2 and the odd samples'
+    // O[k] = (Z[k] - conj(Z[H-k])) / 2j, and X[k] = E[k] + W^k O[k].
+    // Bins k and H - k come from the same pair, so they are done together.
+    double z0_real = out_real[0], z0_imag = out_imag[0];
+    out_real[0] = z0_real + z0_imag;
+    out_imag[0] = 0.0;
+    out_real[H] = z0_real - z0_imag;
+    out_imag[H] = 0.0;
+    for (int k = 1; k <= H / 2; ++k) {
+        double a_real = out_real[k], a_imag = out_imag[k];
+        double b_real = out_real[H - k], b_imag = out_imag[H - k];
+        double even_real = 0.5 * (a_real + b_real);
+        double even_imag = 0.5 * (a_imag - b_imag);
+        double odd_real = 0.5 * (a_imag + b_imag);
+        double odd_imag = -0.5 * (a_real - b_real);
+        double w_real = plan->twiddles_real[k], w_imag = plan->twiddles_imag[k];
+        double wo_real = w_real * odd_real - w_imag * odd_imag;
+        double wo_imag = w_real * odd_imag + w_imag * odd_real;
+        // X[H-k] = conj(E[k] - W^k O[k])
+        out_real[H - k] = even_real - wo_real;
+        out_imag[H - k] = wo_imag - even_imag;
+        out_real[k] = even_real + wo_real;
+        out_imag[k] = even_imag + wo_imag;
+    }
+}
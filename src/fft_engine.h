@@ -0,0 +1,72 @@
+#ifndef FFT_ENGINE_H
+#define FFT_ENGINE_H
+
+// The FFT itself, free of SDL so the channel model and the headless
+// generator can use it as well as the spectrum view.
+//
+// Data is held split, real parts in one array and imaginary parts in
+// another, so the butterflies load whole vectors of either straight from
+// memory. The passes are radix-4 (a radix-2 pass first when the size is
+// an odd power of two) and come from fft_kernels, picked for the CPU.
+
+typedef struct {
+    double real;
+    double imag;
+} Complex;
+
+// Everything a transform of one size needs that doesn't depend on the
+// data: the bit-reversal permutation and the twiddle factors, each
+// computed directly with cos/sin rather than by repeated rotation, so
+// they stay exact at any size. A plan is read-only once built and can be
+// shared between threads.
+typedef struct {
+    int size;
+    int* bit_reverse;  // bit_reverse[i] is i with its bits reversed
+    Complex* twiddles; // e^(-2 pi j k / size) for k < size / 2
+    // The twiddles of each radix-4 pass in turn, laid out contiguously:
+    // for a pass over quarters of q points, q values each of w1 real,
+    // w1 imaginary, w2 real and w2 imaginary
+    double* pass_twiddles;
+} FftPlan;
+
+// 'count' doubles aligned for the widest vectors, released with
+// aligned_buffer_free().
+// NULL if the allocation fails.
+double* fft_buffer_alloc(int count);
+
+// NULL if 'size' isn't a power of two or an allocation fails
+FftPlan* fft_plan_create(int size);
+void fft_plan_destroy(FftPlan* plan);
+
+// In-place transforms of plan->size points held as separate real and
+// imaginary arrays. The inverse is unscaled, so a forward/inverse round
+// trip multiplies by the size.
+void fft_forward(const FftPlan* plan, double* real, double* imag);
+void fft_inverse(const FftPlan* plan, double* real, double* imag);
+
+// The plain radix-2 transform on interleaved Complex values, kept as the
+// reference tests/test_fft.c checks every kernel set against
+void fft_reference_forward(const FftPlan* plan, Complex* x);
+void fft_reference_inverse(const FftPlan* plan, Complex* x);
+
+// Transform of 'size' real samples. They are packed into size / 2 complex
+// values (even samples real, odd imaginary), run through the half-size
+// FFT and untangled, which costs about half a complex transform of the
+// same size.
+typedef struct {
+    int size;
+    FftPlan* half;
+    double* twiddles_real; // e^(-2 pi j k / size) for k < size / 2
+    double* twiddles_imag;
+} FftRealPlan;
+
+// 'size' must be a power of two, at least 2. NULL if an allocation fails.
+FftRealPlan* fft_real_plan_create(int size);
+void fft_real_plan_destroy(FftRealPlan* plan);
+
+// Writes bins 0 to size / 2 (size / 2 + 1 values) of the spectrum of
+// 'in' to 'out_real' and 'out_imag'; the rest are their complex
+// conjugates. 'in' must not overlap either output.
+void fft_real_forward(const FftRealPlan* plan, const double* in, double* out_real, double* out_imag);
+
+#endif // FFT_ENGINE_H
@@ -0,0 +1,346 @@
+#include "fft_kernels.h"
+#include <stddef.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__) && (defined(__GNUC__) || defined(__clang__))
+#define FFT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && !defined(__EMSCRIPTEN__)
+#define FFT_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Every pass works on four quarters of each block, a, b, c and d:
+//   a' = a + w1 b, b' = a - w1 b, c' = c + w1 d, d' = c - w1 d
+//   a = a' + w2 c', c = a' - w2 c', b = b' - j w2 d', d = b' + j w2 d'
+// which is the radix-2 stages of half and full block size in one sweep.
+
+// --- Scalar reference ---
+
+static void radix4_scalar(double* real, double* imag, int size, int quarter,
+                          const double* w1_real, const double* w1_imag,
+                          const double* w2_real, const double* w2_imag) {
+    for (int i = 0; i < size; i += 4 * quarter) {
+        double* r0 = real + i;
+        double* r1 = r0 + quarter;
+        double* r2 = r1 + quarter;
+        double* r3 = r2 + quarter;
+        double* i0 = imag + i;
+        double* i1 = i0 + quarter;
+        double* i2 = i1 + quarter;
+        double* i3 = i2 + quarter;
+        for (int j = 0; j < quarter; ++j) {
+            double tr = w1_real[j] * r1[j] - w1_imag[j] * i1[j];
+            double ti = w1_real[j] * i1[j] + w1_imag[j] * r1[j];
+            double ar = r0[j] + tr, ai = i0[j] + ti;
+            double br = r0[j] - tr, bi = i0[j] - ti;
+            tr = w1_real[j] * r3[j] - w1_imag[j] * i3[j];
+            ti = w1_real[j] * i3[j] + w1_imag[j] * r3[j];
+            double cr = r2[j] + tr, ci = i2[j] + ti;
+            double dr = r2[j] - tr, di = i2[j] - ti;
+
+            tr = w2_real[j] * cr - w2_imag[j] * ci;
+            ti = w2_real[j] * ci + w2_imag[j] * cr;
+            double ur = w2_real[j] * dr - w2_imag[j] * di;
+            double ui = w2_real[j] * di + w2_imag[j] * dr;
+            r0[j] = ar + tr;
+            i0[j] = ai + ti;
+            r2[j] = ar - tr;
+            i2[j] = ai - ti;
+            r1[j] = br + ui;
+            i1[j] = bi - ur;
+            r3[j] = br - ui;
+            i3[j] = bi + ur;
+        }
+    }
+}
+
+static const FftKernels kernels_scalar = {"scalar", radix4_scalar};
+
+#ifdef FFT_KERNELS_X86
+
+// --- SSE2 (2 doubles) ---
+
+__attribute__((target("sse2")))
+static void radix4_sse2(double* real, double* imag, int size, int quarter,
+                        const double* w1_real, const double* w1_imag,
+                        const double* w2_real, const double* w2_imag) {
+    // The first passes have blocks narrower than a vector
+    if (quarter < 2) {
+        radix4_scalar(real, imag, size, quarter, w1_real, w1_imag, w2_real, w2_imag);
+        return;
+    }
+    for (int i = 0; i < size; i += 4 * quarter) {
+        double* r0 = real + i;
+        double* r1 = r0 + quarter;
+        double* r2 = r1 + quarter;
+        double* r3 = r2 + quarter;
+        double* i0 = imag + i;
+        double* i1 = i0 + quarter;
+        double* i2 = i1 + quarter;
+        double* i3 = i2 + quarter;
+        for (int j = 0; j < quarter; j += 2) {
+            __m128d w1r = _mm_loadu_pd(w1_real + j), w1i = _mm_loadu_pd(w1_imag + j);
+            __m128d w2r = _mm_loadu_pd(w2_real + j), w2i = _mm_loadu_pd(w2_imag + j);
+            __m128d xr = _mm_loadu_pd(r1 + j), xi = _mm_loadu_pd(i1 + j);
+            __m128d tr = _mm_sub_pd(_mm_mul_pd(w1r, xr), _mm_mul_pd(w1i, xi));
+            __m128d ti = _mm_add_pd(_mm_mul_pd(w1r, xi), _mm_mul_pd(w1i, xr));
+            xr = _mm_loadu_pd(r0 + j);
+            xi = _mm_loadu_pd(i0 + j);
+            __m128d ar = _mm_add_pd(xr, tr), ai = _mm_add_pd(xi, ti);
+            __m128d br = _mm_sub_pd(xr, tr), bi = _mm_sub_pd(xi, ti);
+            xr = _mm_loadu_pd(r3 + j);
+            xi = _mm_loadu_pd(i3 + j);
+            tr = _mm_sub_pd(_mm_mul_pd(w1r, xr), _mm_mul_pd(w1i, xi));
+            ti = _mm_add_pd(_mm_mul_pd(w1r, xi), _mm_mul_pd(w1i, xr));
+            xr = _mm_loadu_pd(r2 + j);
+            xi = _mm_loadu_pd(i2 + j);
+            __m128d cr = _mm_add_pd(xr, tr), ci = _mm_add_pd(xi, ti);
+            __m128d dr = _mm_sub_pd(xr, tr), di = _mm_sub_pd(xi, ti);
+
+            tr = _mm_sub_pd(_mm_mul_pd(w2r, cr), _mm_mul_pd(w2i, ci));
+            ti = _mm_add_pd(_mm_mul_pd(w2r, ci), _mm_mul_pd(w2i, cr));
+            __m128d ur = _mm_sub_pd(_mm_mul_pd(w2r, dr), _mm_mul_pd(w2i, di));
+            __m128d ui = _mm_add_pd(_mm_mul_pd(w2r, di), _mm_mul_pd(w2i, dr));
+            _mm_storeu_pd(r0 + j, _mm_add_pd(ar, tr));
+            _mm_storeu_pd(i0 + j, _mm_add_pd(ai, ti));
+            _mm_storeu_pd(r2 + j, _mm_sub_pd(ar, tr));
+            _mm_storeu_pd(i2 + j, _mm_sub_pd(ai, ti));
+            _mm_storeu_pd(r1 + j, _mm_add_pd(br, ui));
+            _mm_storeu_pd(i1 + j, _mm_sub_pd(bi, ur));
+            _mm_storeu_pd(r3 + j, _mm_sub_pd(br, ui));
+            _mm_storeu_pd(i3 + j, _mm_add_pd(bi, ur));
+        }
+    }
+}
+
+static const FftKernels kernels_sse2 = {"sse2", radix4_sse2};
+
+// --- AVX2 + FMA (4 doubles) ---
+
+__attribute__((target("avx2,fma")))
+static void radix4_avx2(double* real, double* imag, int size, int quarter,
+                        const double* w1_real, const double* w1_imag,
+                        const double* w2_real, const double* w2_imag) {
+    if (quarter < 4) {
+        radix4_scalar(real, imag, size, quarter, w1_real, w1_imag, w2_real, w2_imag);
+        return;
+    }
+    for (int i = 0; i < size; i += 4 * quarter) {
+        double* r0 = real + i;
+        double* r1 = r0 + quarter;
+        double* r2 = r1 + quarter;
+        double* r3 = r2 + quarter;
+        double* i0 = imag + i;
+        double* i1 = i0 + quarter;
+        double* i2 = i1 + quarter;
+        double* i3 = i2 + quarter;
+        for (int j = 0; j < quarter; j += 4) {
+            __m256d w1r = _mm256_loadu_pd(w1_real + j), w1i = _mm256_loadu_pd(w1_imag + j);
+            __m256d w2r = _mm256_loadu_pd(w2_real + j), w2i = _mm256_loadu_pd(w2_imag + j);
+            __m256d xr = _mm256_loadu_pd(r1 + j), xi = _mm256_loadu_pd(i1 + j);
+            __m256d tr = _mm256_fmsub_pd(w1r, xr, _mm256_mul_pd(w1i, xi));
+            __m256d ti = _mm256_fmadd_pd(w1r, xi, _mm256_mul_pd(w1i, xr));
+            xr = _mm256_loadu_pd(r0 + j);
+            xi = _mm256_loadu_pd(i0 + j);
+            __m256d ar = _mm256_add_pd(xr, tr), ai = _mm256_add_pd(xi, ti);
+            __m256d br = _mm256_sub_pd(xr, tr), bi = _mm256_sub_pd(xi, ti);
+            xr = _mm256_loadu_pd(r3 + j);
+            xi = _mm256_loadu_pd(i3 + j);
+            tr = _mm256_fmsub_pd(w1r, xr, _mm256_mul_pd(w1i, xi));
+            ti = _mm256_fmadd_pd(w1r, xi, _mm256_mul_pd(w1i, xr));
+            xr = _mm256_loadu_pd(r2 + j);
+            xi = _mm256_loadu_pd(i2 + j);
+            __m256d cr = _mm256_add_pd(xr, tr), ci = _mm256_add_pd(xi, ti);
+            __m256d dr = _mm256_sub_pd(xr, tr), di = _mm256_sub_pd(xi, ti);
+
+            tr = _mm256_fmsub_pd(w2r, cr, _mm256_mul_pd(w2i, ci));
+            ti = _mm256_fmadd_pd(w2r, ci, _mm256_mul_pd(w2i, cr));
+            __m256d ur = _mm256_fmsub_pd(w2r, dr, _mm256_mul_pd(w2i, di));
+            __m256d ui = _mm256_fmadd_pd(w2r, di, _mm256_mul_pd(w2i, dr));
+            _mm256_storeu_pd(r0 + j, _mm256_add_pd(ar, tr));
+            _mm256_storeu_pd(i0 + j, _mm256_add_pd(ai, ti));
+            _mm256_storeu_pd(r2 + j, _mm256_sub_pd(ar, tr));
+            _mm256_storeu_pd(i2 + j, _mm256_sub_pd(ai, ti));
+            _mm256_storeu_pd(r1 + j, _mm256_add_pd(br, ui));
+            _mm256_storeu_pd(i1 + j, _mm256_sub_pd(bi, ur));
+            _mm256_storeu_pd(r3 + j, _mm256_sub_pd(br, ui));
+            _mm256_storeu_pd(i3 + j, _mm256_add_pd(bi, ur));
+        }
+    }
+}
+
+static const FftKernels kernels_avx2 = {"avx2", radix4_avx2};
+
+// --- AVX-512F (8 doubles) ---
+
+__attribute__((target("avx512f")))
+static void radix4_avx512(double* real, double* imag, int size, int quarter,
+                          const double* w1_real, const double* w1_imag,
+                          const double* w2_real, const double* w2_imag) {
+    if (quarter < 8) {
+        radix4_scalar(real, imag, size, quarter, w1_real, w1_imag, w2_real, w2_imag);
+        return;
+    }
+    for (int i = 0; i < size; i += 4 * quarter) {
+        double* r0 = real + i;
+        double* r1 = r0 + quarter;
+        double* r2 = r1 + quarter;
+        double* r3 = r2 + quarter;
+        double* i0 = imag + i;
+        double* i1 = i0 + quarter;
+        double* i2 = i1 + quarter;
+        double* i3 = i2 + quarter;
+        for (int j = 0; j < quarter; j += 8) {
+            __m512d w1r = _mm512_loadu_pd(w1_real + j), w1i = _mm512_loadu_pd(w1_imag + j);
+            __m512d w2r = _mm512_loadu_pd(w2_real + j), w2i = _mm512_loadu_pd(w2_imag + j);
+            __m512d xr = _mm512_loadu_pd(r1 + j), xi = _mm512_loadu_pd(i1 + j);
+            __m512d tr = _mm512_fmsub_pd(w1r, xr, _mm512_mul_pd(w1i, xi));
+            __m512d ti = _mm512_fmadd_pd(w1r, xi, _mm512_mul_pd(w1i, xr));
+            xr = _mm512_loadu_pd(r0 + j);
+            xi = _mm512_loadu_pd(i0 + j);
+            __m512d ar = _mm512_add_pd(xr, tr), ai = _mm512_add_pd(xi, ti);
+            __m512d br = _mm512_sub_pd(xr, tr), bi = _mm512_sub_pd(xi, ti);
+            xr = _mm512_loadu_pd(r3 + j);
+            xi = _mm512_loadu_pd(i3 + j);
+            tr = _mm512_fmsub_pd(w1r, xr, _mm512_mul_pd(w1i, xi));
+            ti = _mm512_fmadd_pd(w1r, xi, _mm512_mul_pd(w1i, xr));
+            xr = _mm512_loadu_pd(r2 + j);
+            xi = _mm512_loadu_pd(i2 + j);
+            __m512d cr = _mm512_add_pd(xr, tr), ci = _mm512_add_pd(xi, ti);
+            __m512d dr = _mm512_sub_pd(xr, tr), di = _mm512_sub_pd(xi, ti);
+
+            tr = _mm512_fmsub_pd(w2r, cr, _mm512_mul_pd(w2i, ci));
+            ti = _mm512_fmadd_pd(w2r, ci, _mm512_mul_pd(w2i, cr));
+            __m512d ur = _mm512_fmsub_pd(w2r, dr, _mm512_mul_pd(w2i, di));
+            __m512d ui = _mm512_fmadd_pd(w2r, di, _mm512_mul_pd(w2i, dr));
+            _mm512_storeu_pd(r0 + j, _mm512_add_pd(ar, tr));
+            _mm512_storeu_pd(i0 + j, _mm512_add_pd(ai, ti));
+            _mm512_storeu_pd(r2 + j, _mm512_sub_pd(ar, tr));
+            _mm512_storeu_pd(i2 + j, _mm512_sub_pd(ai, ti));
+            _mm512_storeu_pd(r1 + j, _mm512_add_pd(br, ui));
+            _mm512_storeu_pd(i1 + j, _mm512_sub_pd(bi, ur));
+            _mm512_storeu_pd(r3 + j, _mm512_sub_pd(br, ui));
+            _mm512_storeu_pd(i3 + j, _mm512_add_pd(bi, ur));
+        }
+    }
+}
+
+static const FftKernels kernels_avx512 = {"avx512", radix4_avx512};
+
+#endif // FFT_KERNELS_X86
+
+#ifdef FFT_KERNELS_NEON
+
+// --- NEON (2 doubles, AArch64 baseline) ---
+
+static void radix4_neon(double* real, double* imag, int size, int quarter,
+                        const double* w1_real, const double* w1_imag,
+                        const double* w2_real, const double* w2_imag) {
+    if (quarter < 2) {
+        radix4_scalar(real, imag, size, quarter, w1_real, w1_imag, w2_real, w2_imag);
+        return;
+    }
+    for (int i = 0; i < size; i += 4 * quarter) {
+        double* r0 = real + i;
+        double* r1 = r0 + quarter;
+        double* r2 = r1 + quarter;
+        double* r3 = r2 + quarter;
+        double* i0 = imag + i;
+        double* i1 = i0 + quarter;
+        double* i2 = i1 + quarter;
+        double* i3 = i2 + quarter;
+        for (int j = 0; j < quarter; j += 2) {
+            float64x2_t w1r = vld1q_f64(w1_real + j), w1i = vld1q_f64(w1_imag + j);
+            float64x2_t w2r = vld1q_f64(w2_real + j), w2i = vld1q_f64(w2_imag + j);
+            float64x2_t xr = vld1q_f64(r1 + j), xi = vld1q_f64(i1 + j);
+            float64x2_t tr = vfmsq_f64(vmulq_f64(w1r, xr), w1i, xi);
+            float64x2_t ti = vfmaq_f64(vmulq_f64(w1r, xi), w1i, xr);
+            xr = vld1q_f64(r0 + j);
+            xi = vld1q_f64(i0 + j);
+            float64x2_t ar = vaddq_f64(xr, tr), ai = vaddq_f64(xi, ti);
+            float64x2_t br = vsubq_f64(xr, tr), bi = vsubq_f64(xi, ti);
+            xr = vld1q_f64(r3 + j);
+            xi = vld1q_f64(i3 + j);
+            tr = vfmsq_f64(vmulq_f64(w1r, xr), w1i, xi);
+            ti = vfmaq_f64(vmulq_f64(w1r, xi), w1i, xr);
+            xr = vld1q_f64(r2 + j);
+            xi = vld1q_f64(i2 + j);
+            float64x2_t cr = vaddq_f64(xr, tr), ci = vaddq_f64(xi, ti);
+            float64x2_t dr = vsubq_f64(xr, tr), di = vsubq_f64(xi, ti);
+
+            tr = vfmsq_f64(vmulq_f64(w2r, cr), w2i, ci);
+            ti = vfmaq_f64(vmulq_f64(w2r, ci), w2i, cr);
+            float64x2_t ur = vfmsq_f64(vmulq_f64(w2r, dr), w2i, di);
+            float64x2_t ui = vfmaq_f64(vmulq_f64(w2r, di), w2i, dr);
+            vst1q_f64(r0 + j, vaddq_f64(ar, tr));
+            vst1q_f64(i0 + j, vaddq_f64(ai, ti));
+            vst1q_f64(r2 + j, vsubq_f64(ar, tr));
+            vst1q_f64(i2 + j, vsubq_f64(ai, ti));
+            vst1q_f64(r1 + j, vaddq_f64(br, ui));
+            vst1q_f64(i1 + j, vsubq_f64(bi, ur));
+            vst1q_f64(r3 + j, vsubq_f64(br, ui));
+            vst1q_f64(i3 + j, vaddq_f64(bi, ur));
+        }
+    }
+}
+
+static const FftKernels kernels_neon = {"neon", radix4_neon};
+
+#endif // FFT_KERNELS_NEON
+
+// --- Dispatch ---
+
+static const FftKernels* active_kernels = NULL;
+
+static bool kernels_supported(const FftKernels* kernels) {
+    if (kernels == &kernels_scalar) return true;
+#ifdef FFT_KERNELS_X86
+    __builtin_cpu_init();
+    if (kernels == &kernels_sse2) return __builtin_cpu_supports("sse2");
+    if (kernels == &kernels_avx2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (kernels == &kernels_avx512) return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef FFT_KERNELS_NEON
+    if (kernels == &kernels_neon) return true;
+#endif
+    return false;
+}
+
+// Widest first
+static const FftKernels* const all_kernels[] = {
+#ifdef FFT_KERNELS_X86
+    &kernels_avx512, &kernels_avx2, &kernels_sse2,
+#endif
+#ifdef FFT_KERNELS_NEON
+    &kernels_neon,
+#endif
+    &kernels_scalar,
+};
+
+void fft_kernels_init(void) {
+    if (active_kernels != NULL) return;
+    for (size_t i = 0; i < sizeof(all_kernels) / sizeof(all_kernels[0]); ++i) {
+        if (kernels_supported(all_kernels[i])) {
+            active_kernels = all_kernels[i];
+            return;
+        }
+    }
+}
+
+const FftKernels* fft_kernels_get(void) {
+    fft_kernels_init();
+    return active_kernels;
+}
+
+bool fft_kernels_select(const char* name) {
+    for (size_t i = 0; i < sizeof(all_kernels) / sizeof(all_kernels[0]); ++i) {
+        if (strcmp(all_kernels[i]->name, name) == 0 && kernels_supported(all_kernels[i])) {
+            active_kernels = all_kernels[i];
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,27 @@
+#ifndef FFT_KERNELS_H
+#define FFT_KERNELS_H
+
+#include <stdbool.h>
+
+// The butterfly passes the FFT is built from, on split real/imaginary
+// arrays. As with the modulator's kernels, the scalar set is the
+// reference and the vector sets compute the same thing, differing only
+// in rounding where they use fused multiply-add.
+typedef struct {
+    const char* name;
+    // One radix-4 pass over 'size' points in blocks of 4 * quarter: two
+    // radix-2 stages fused, the first with twiddles w1[j] and the second
+    // with w2[j] (and -j w2[j]) for j < quarter
+    void (*radix4)(double* real, double* imag, int size, int quarter,
+                   const double* w1_real, const double* w1_imag,
+                   const double* w2_real, const double* w2_imag);
+} FftKernels;
+
+// Picks the widest instruction set the CPU supports. Safe to call again.
+void fft_kernels_init(void);
+const FftKernels* fft_kernels_get(void);
+// Forces an implementation by name ("scalar", "sse2", "avx2", "avx512",
+// "neon"). Returns false if it isn't available on this machine.
+bool fft_kernels_select(const char* name);
+
+#endif // FFT_KERNELS_H
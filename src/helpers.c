@@ -1,7 +1,11 @@
 // src/helpers.c
 
-#include "shared.h"
+#include "dsp_common.h"
 #include <math.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 // Sinc function: sin(pi*x) / (pi*x)
 double sinc(double x) {
@@ -11,10 +15,9 @@ double sinc(double x) {
     return sin(M_PI * x) / (M_PI * x);
 }
 
-// Raised Cosine pulse shaping function
+// Raised Cosine pulse shaping function. Untruncated: the pulse shaper
+// decides how many symbols of it to keep.
 double raised_cosine(double t, double T_s, double beta) {
-    if (fabs(t) > 4 * T_s) return 0; // Widen window slightly for accuracy
-
     if (fabs(t) < 1e-9) {
         return 1.0;
     }
@@ -29,19 +32,39 @@ double raised_cosine(double t, double T_s, double beta) {
 }
 
 // Fetches the integer value of a symbol from the message buffer
-int get_symbol_at_index(int symbol_index, const char* message, int message_len, int bits_per_sym) {
-    int start_bit_index = symbol_index * bits_per_sym;
+int get_symbol_at_index(int64_t symbol_index, const char* message, int64_t message_len, int bits_per_sym) {
+    int64_t start_bit_index = symbol_index * bits_per_sym;
     if ((start_bit_index / 8) >= message_len) return 0;
 
     int symbol_value = 0;
     for (int i = 0; i < bits_per_sym; ++i) {
-        int current_bit_index = start_bit_index + i;
-        int char_index = current_bit_index / 8;
+        int64_t current_bit_index = start_bit_index + i;
+        int64_t char_index = current_bit_index / 8;
         if (char_index >= message_len) continue;
 
-        int bit_in_char = current_bit_index % 8;
+        int bit_in_char = (int)(current_bit_index % 8);
         int bit = (message[char_index] >> (7 - bit_in_char)) & 1;
         symbol_value = (symbol_value << 1) | bit;
     }
     return symbol_value;
-}
\ No newline at end of file
+}
+
+// C11 aligned_alloc is missing from the Windows C runtime, which has its
+// own pair instead
+void* aligned_buffer_alloc(size_t alignment, size_t bytes) {
+    if (bytes == 0) bytes = 1;
+#ifdef _WIN32
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* buffer = NULL;
+    return posix_memalign(&buffer, alignment, bytes) == 0 ? buffer : NULL;
+#endif
+}
+
+void aligned_buffer_free(void* buffer) {
+#ifdef _WIN32
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
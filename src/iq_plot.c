@@ -1,61 +1,154 @@
 #include "iq_plot.h"
 #include "shared.h"
+#include "constellation.h"
+#include "channel.h"
+#include "nco.h"
+#include "pulse_shaper.h"
 #include <math.h>
 #include <stdlib.h>
 
+// Downconverts the channel output around the plotted symbols
+typedef struct {
+    const double* samples;     // the window, from the waveform cache
+    int64_t start;             // its first sample's position in the loop
+    double hilbert[CHANNEL_HILBERT_HALF + 1];
+    uint32_t carrier_increment;
+    double inverse_amplitude;
+    const double* matched;     // receive filter, NULL for none
+    int matched_half;
+    double* envelope_I;        // the envelope at every sample the filter reads
+    double* envelope_Q;
+} Receiver;
+
+// Complex envelope at window sample 'i', relative to the carrier: the
+// analytic signal turned back by the carrier phase, in units of the
+// amplitude. Reads CHANNEL_HILBERT_HALF samples either side of i.
+static void receive_envelope(const Receiver* rx, int i, double* I, double* Q) {
+    const double* x = rx->samples;
+    double quadrature = 0.0;
+    for (int k = 1; k <= CHANNEL_HILBERT_HALF; k += 2) {
+        quadrature += rx->hilbert[k] * (x[i - k] - x[i + k]);
+    }
+    uint32_t phase = (uint32_t)((uint64_t)(rx->start + i) * rx->carrier_increment);
+    double c = nco_cos(phase, NCO_PRECISION_INTERP_LUT);
+    double s = nco_sin(phase, NCO_PRECISION_INTERP_LUT);
+    *I = (x[i] * c + quadrature * s) * rx->inverse_amplitude;
+    *Q = (quadrature * c - x[i] * s) * rx->inverse_amplitude;
+}
+
+// The receiver's output at window sample 'i': the envelope, through the
+// matched filter if there is one
+static void receive_sample(const Receiver* rx, int i, double* I, double* Q) {
+    if (rx->matched == NULL) {
+        receive_envelope(rx, i, I, Q);
+        return;
+    }
+    double sum_I = 0.0, sum_Q = 0.0;
+    for (int k = -rx->matched_half; k <= rx->matched_half; ++k) {
+        double h = rx->matched[rx->matched_half + k];
+        sum_I += h * rx->envelope_I[i - k];
+        sum_Q += h * rx->envelope_Q[i - k];
+    }
+    *I = sum_I;
+    *Q = sum_Q;
+}
+
 void draw_iq_plot(
     SDL_Renderer* renderer,
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type)
+    Waveform* waveform)
 {
     SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
     SDL_RenderDrawLine(renderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
     SDL_RenderDrawLine(renderer, SCREEN_WIDTH / 2, 0, SCREEN_WIDTH / 2, SCREEN_HEIGHT);
 
-    if (activeMessageLength <= 0) return;
+    const SymbolTable* symbols = waveform->symbols;
+    const ModulatorParams* params = &waveform->params;
+    if (symbols == NULL || symbols->count <= 0 || waveform->total_samples <= 0) return;
+
+    const Constellation* constellation = constellation_get(params->mod_type, params->bits_per_symbol);
+    if (constellation == NULL) return;
+
+    // A short message is plotted whole. A large payload would be billions
+    // of points, so plot the symbols under the current scroll position,
+    // and fewer of them when they are long.
+    int sps = params->samples_per_symbol;
+    int64_t first_symbol = 0;
+    int total_symbols = (int)symbols->count;
+    int most_symbols = IQ_PLOT_MAX_SAMPLES / sps;
+    if (most_symbols > IQ_PLOT_MAX_SYMBOLS) most_symbols = IQ_PLOT_MAX_SYMBOLS;
+    if (most_symbols < 1) most_symbols = 1;
+    if (symbols->count > most_symbols) {
+        first_symbol = sample_clock / pixelsPerBit % symbols->count;
+        total_symbols = most_symbols;
+    }
+
+    // Each point is the channel output downconverted at its symbol's
+    // centre, (j + 0.5) symbol periods in, averaging the two samples
+    // either side when that falls between them. A root-raised-cosine
+    // signal goes through its matched filter first, which makes the pair
+    // a raised cosine with no ISI at the centres. FSK has no envelope to
+    // sample, so its tones keep their places around the circle.
+    Receiver rx = {0};
+    int margin = CHANNEL_HILBERT_HALF + 1;
+    if (params->mod_type != MOD_FSK) {
+        if (params->pulse_shape == PULSE_ROOT_RAISED_COSINE) {
+            rx.matched_half = params->pulse_span * sps;
+            double* matched = workspace_doubles(&frame_workspace, 2 * rx.matched_half + 1);
+            if (matched == NULL) return;
+            pulse_shaper_matched_filter(params->pulse_shape, params->rolloff, sps, params->pulse_span,
+                                        matched, 2 * rx.matched_half + 1);
+            rx.matched = matched;
+            margin += rx.matched_half;
+        }
 
-    int M = 1 << bitsPerSymbol;
-    int total_symbols = (activeMessageLength * 8) / bitsPerSymbol;
+        int64_t start = first_symbol * sps - margin;
+        int window_length = total_symbols * sps + 2 * margin;
+        rx.samples = waveform_window(waveform, start, window_length, &frame_workspace);
+        if (rx.samples == NULL) return;
+        rx.start = start % waveform->total_samples;
+        if (rx.start < 0) rx.start += waveform->total_samples;
+        channel_hilbert_taps(rx.hilbert);
+        rx.carrier_increment = nco_increment(params->frequency, params->sampling_rate);
+        rx.inverse_amplitude = params->amplitude != 0.0 ? 1.0 / params->amplitude : 0.0;
+
+        if (rx.matched != NULL) {
+            rx.envelope_I = workspace_doubles(&frame_workspace, window_length);
+            rx.envelope_Q = workspace_doubles(&frame_workspace, window_length);
+            if (rx.envelope_I == NULL || rx.envelope_Q == NULL) return;
+            for (int i = CHANNEL_HILBERT_HALF; i < window_length - CHANNEL_HILBERT_HALF; ++i) {
+                receive_envelope(&rx, i, &rx.envelope_I[i], &rx.envelope_Q[i]);
+            }
+        }
+    }
 
     int prev_x_pos = SCREEN_WIDTH / 2;
     int prev_y_pos = SCREEN_HEIGHT / 2;
 
     for (int i = 0; i < total_symbols; ++i) {
-        int symbol_value = get_symbol_at_index(i, activeMessage, activeMessageLength, bitsPerSymbol);
-        double ideal_I = 0.0, ideal_Q = 0.0;
-
-        switch (current_mod_type) {
-            case MOD_ASK: {
-                ideal_I = (M == 1) ? symbol_value : (double)symbol_value / (M - 1);
-                ideal_Q = 0.0;
-                break;
-            }
-            case MOD_FSK:
-            case MOD_PSK: {
-                double angle = (2.0 * M_PI * symbol_value) / M;
-                if (current_mod_type == MOD_PSK && M == 4) angle += M_PI / 4.0;
-                ideal_I = cos(angle);
-                ideal_Q = sin(angle);
-                break;
+        double point_I, point_Q;
+        if (rx.samples == NULL) {
+            int symbol_value = symbol_table_value(symbols, (first_symbol + i) % symbols->count);
+            point_I = constellation->I[symbol_value];
+            point_Q = constellation->Q[symbol_value];
+        } else {
+            int before = margin + i * sps + sps / 2;
+            int after = before + (sps & 1);
+            double I0, Q0, I1, Q1;
+            receive_sample(&rx, before, &I0, &Q0);
+            receive_sample(&rx, after, &I1, &Q1);
+            point_I = 0.5 * (I0 + I1);
+            point_Q = 0.5 * (Q0 + Q1);
+            if (!constellation->is_complex) {
+                // A real envelope rides on the sine, a quarter turn behind
+                double I = -point_Q;
+                point_Q = point_I;
+                point_I = I;
             }
         }
 
-        double noise_I = 0.0, noise_Q = 0.0;
-        if (snr_db < 100) {
-            double snr_linear = pow(10.0, snr_db / 10.0);
-            double noise_power_per_channel = 0.5 / snr_linear;
-            double noise_std_dev = sqrt(noise_power_per_channel);
-            
-            double u1 = (rand() + 1.0) / (RAND_MAX + 1.0);
-            double u2 = (rand() + 1.0) / (RAND_MAX + 1.0);
-            noise_I = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2) * noise_std_dev;
-            noise_Q = sqrt(-2.0 * log(u1)) * sin(2.0 * M_PI * u2) * noise_std_dev;
-        }
-
         float plot_scale = SCREEN_HEIGHT / 3.0;
-        int x_pos = SCREEN_WIDTH / 2 + (int)((ideal_I + noise_I) * plot_scale);
-        int y_pos = SCREEN_HEIGHT / 2 - (int)((ideal_Q + noise_Q) * plot_scale);
+        int x_pos = SCREEN_WIDTH / 2 + (int)(point_I * plot_scale);
+        int y_pos = SCREEN_HEIGHT / 2 - (int)(point_Q * plot_scale);
 
         if (i > 0) {
             SDL_SetRenderDrawColor(renderer, 0, 150, 255, 100);
@@ -69,4 +162,4 @@ void draw_iq_plot(
         prev_x_pos = x_pos;
         prev_y_pos = y_pos;
     }
-}
\ No newline at end of file
+}
@@ -2,12 +2,16 @@
 #define IQ_PLOT_H
 
 #include "shared.h"
+#include "modulator.h"
+
+// Most symbols drawn per frame
+#define IQ_PLOT_MAX_SYMBOLS 4096
+// Most samples read per frame, which draws fewer of long symbols
+#define IQ_PLOT_MAX_SAMPLES (1 << 18)
 
 void draw_iq_plot(
     SDL_Renderer* renderer,
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type
+    Waveform* waveform
 );
 
 #endif // IQ_PLOT_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <math.h>
 
 #include "shared.h"
 #include "text_renderer.h"
@@ -12,6 +13,19 @@
 #include "iq_plot.h"
 #include "fft.h"
 #include "export_waveform.h"
+#include "modulator.h"
+#include "symbols.h"
+#include "pulse_shaper.h"
+#include "mod_kernels.h"
+#include "fft_kernels.h"
+#include "parallel.h"
+#include "payload.h"
+#include "constellation.h"
+#include "noise.h"
+
+#ifndef __EMSCRIPTEN__
+#include "tinyfiledialogs.h"
+#endif
 
 #define INPUT_BUFFER_SIZE 256
 #ifndef M_PI
@@ -29,7 +43,8 @@ int pixelsPerBit = 50;
 double snr_db = 100.0;
 double rolloff_factor = 0.35;
 int bitsPerSymbol = 1;
-double time_offset = 0.0;
+int64_t sample_clock = 0; // Index of the first sample on screen
+double sample_clock_fraction = 0.0; // Sub-sample part of the scroll position
 double sampling_rate = 4000.0;
 double pixels_per_second = 500.0;
 double spectrum_center_freq = 1000.0; 
@@ -37,13 +52,32 @@ double spectrum_span = 1000.0;
 int fft_size = 2048;   
 WindowType current_window_type = WINDOW_HANN;   
 int spectrum_power = 1;
+SpectrumAveraging spectrum_averaging = SPECTRUM_SINGLE;
+double spectrum_overlap = 0.5; // fraction of each Welch segment shared with the next
+int spectrum_segments = 8;     // Welch segments averaged from the view on
 double hovered_frequency = 0.0;
 double hovered_power = -999.0; // Use a very low value to indicate no hover
 int mouse_x = 0;
 int mouse_y = 0;
+int export_threads = 0; // 0 means one per CPU
+double export_rate = 0.0; // 0 means the sampling rate
+uint64_t noise_seed = NOISE_DEFAULT_SEED;
 
 AppMode current_mode = MODE_TYPING;
 ModulationType current_mod_type = MOD_ASK;
+NcoPrecision carrier_precision = NCO_PRECISION_INTERP_LUT;
+SamplePrecision sample_precision = SAMPLE_PRECISION_DOUBLE;
+PulseShape pulse_shape = PULSE_RAISED_COSINE;
+int pulse_span = PULSE_SHAPER_SPAN;
+double gaussian_bt = 0.5;
+MultipathProfile multipath_profile = MULTIPATH_NONE;
+double cfo_hz = 0.0;
+double phase_noise_deg = 0.0;
+double dc_offset = 0.0;
+double iq_gain_db = 0.0;
+double iq_phase_deg = 0.0;
+FadingModel fading_model = FADING_NONE;
+double doppler_hz = 1.0;
 ViewMode current_view = VIEW_TIME_DOMAIN;
 bool needsTextUpdate = true;
 bool needsAngleUpdate = true;
@@ -54,6 +88,10 @@ char inputText[INPUT_BUFFER_SIZE] = {0};
 int inputTextLength = 0;
 char activeMessage[INPUT_BUFFER_SIZE] = {0};
 int activeMessageLength = 0;
+Payload activePayload = {0}; // A loaded file replaces the typed message
+SymbolTable activeSymbols = {0};
+Waveform waveform = {0};
+Workspace frame_workspace = {0};
 
 SDL_Window* window = NULL;
 SDL_Renderer* renderer = NULL;
@@ -61,8 +99,125 @@ TextObject status_line1, status_line2, mode_indicator_text, input_text_display,
 TTF_Font* font_size_20 = NULL;
 TTF_Font* font_size_18 = NULL;
 
+// Snapshot of the globals that shape the rendered waveform
+ModulatorParams current_modulator_params() {
+    ModulatorParams params;
+    params.mod_type = current_mod_type;
+    params.bits_per_symbol = bitsPerSymbol;
+    params.samples_per_symbol = pixelsPerBit;
+    params.amplitude = amplitude;
+    params.frequency = frequency;
+    params.sampling_rate = sampling_rate;
+    params.rolloff = rolloff_factor;
+    params.pulse_shape = pulse_shape;
+    params.pulse_span = pulse_span;
+    params.gaussian_bt = gaussian_bt;
+    params.carrier_precision = carrier_precision;
+    params.sample_precision = sample_precision;
+    return params;
+}
+
+// Rates the export can be resampled to; 0 keeps the sampling rate
+const double export_rate_presets[] = { 0.0, 8000.0, 11025.0, 16000.0, 22050.0, 44100.0, 48000.0, 96000.0 };
+#define EXPORT_RATE_PRESET_COUNT ((int)(sizeof(export_rate_presets) / sizeof(export_rate_presets[0])))
+
+void step_export_rate(int direction) {
+    int index = 0;
+    while (index < EXPORT_RATE_PRESET_COUNT - 1 && export_rate_presets[index] != export_rate) index++;
+    index += direction;
+    if (index < 0) index = 0;
+    if (index >= EXPORT_RATE_PRESET_COUNT) index = EXPORT_RATE_PRESET_COUNT - 1;
+    export_rate = export_rate_presets[index];
+}
+
+ChannelParams current_channel_params() {
+    ChannelParams params;
+    params.snr_db = snr_db;
+    params.noise_seed = noise_seed;
+    params.multipath = multipath_profile;
+    params.cfo_hz = cfo_hz;
+    params.phase_noise_deg = phase_noise_deg;
+    params.phase_noise_bandwidth = 10.0;
+    params.dc_offset = dc_offset;
+    params.iq_gain_db = iq_gain_db;
+    params.iq_phase_deg = iq_phase_deg;
+    params.fading = fading_model;
+    params.doppler_hz = doppler_hz;
+    params.rician_k_db = 6.0;
+    return params;
+}
+
+// Rebuilds the symbol table over the committed message (the loaded payload
+// if there is one), which is only needed when it or the modulation order
+// changed, then refreshes the waveform cache
+void update_signal(bool message_changed) {
+    if (message_changed || activeSymbols.bits_per_symbol != bitsPerSymbol) {
+        if (activePayload.data != NULL) {
+            symbol_table_build(&activeSymbols, activePayload.data, activePayload.length, bitsPerSymbol);
+        } else {
+            symbol_table_build(&activeSymbols, (const unsigned char*)activeMessage, activeMessageLength, bitsPerSymbol);
+        }
+        waveform_set_symbols(&waveform, &activeSymbols);
+    }
+    ModulatorParams params = current_modulator_params();
+    ChannelParams channel = current_channel_params();
+    waveform_update(&waveform, &params, &channel);
+}
+
+// APSK only exists with 16 and 32 points
+void clamp_order_to_modulation() {
+    if (current_mod_type != MOD_APSK) return;
+    if (bitsPerSymbol < CONSTELLATION_APSK_MIN_BITS) bitsPerSymbol = CONSTELLATION_APSK_MIN_BITS;
+    if (bitsPerSymbol > CONSTELLATION_APSK_MAX_BITS) bitsPerSymbol = CONSTELLATION_APSK_MAX_BITS;
+}
+
+void reset_sample_clock() {
+    sample_clock = 0;
+    sample_clock_fraction = 0.0;
+}
+
+// Moves the view by 'seconds'. The sample clock is the timebase; the
+// remainder is carried so slow scrolling doesn't drift.
+void scroll_by(double seconds) {
+    double samples = seconds * sampling_rate + sample_clock_fraction;
+    int64_t whole = (int64_t)floor(samples);
+    sample_clock_fraction = samples - (double)whole;
+    sample_clock += whole;
+    if (sample_clock < 0) reset_sample_clock();
+}
+
+// Maps a payload file chosen in a dialog and makes it the active message
+void load_payload() {
+#ifdef __EMSCRIPTEN__
+    printf("Loading payload files is not supported in the browser build.\n");
+#else
+    const char* path = tinyfd_openFileDialog("Load Payload", "", 0, NULL, NULL, 0);
+    if (path == NULL) return;
+
+    Payload loaded;
+    if (!payload_open(&loaded, path)) {
+        printf("Failed to open payload '%s'.\n", path);
+        return;
+    }
+    if (loaded.length == 0) {
+        printf("Payload '%s' is empty.\n", path);
+        payload_close(&loaded);
+        return;
+    }
+    payload_close(&activePayload);
+    activePayload = loaded;
+    update_signal(true);
+    reset_sample_clock();
+    printf("Loaded payload '%s' (%lld bytes, %lld symbols).\n", path, (long long)activePayload.length, (long long)activeSymbols.count);
+#endif
+}
+
 // --- Main Loop Function ---
 void main_loop() {
+    // Last frame's scratch is reused, so once the sizes settle a frame
+    // allocates nothing
+    workspace_reset(&frame_workspace);
+
     SDL_Event e;
     while (SDL_PollEvent(&e) != 0) {
         if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
@@ -103,14 +258,30 @@ void main_loop() {
                         case SDLK_1: current_mod_type = MOD_ASK; needsTextUpdate = true; break;
                         case SDLK_2: current_mod_type = MOD_FSK; needsTextUpdate = true; break;
                         case SDLK_3: current_mod_type = MOD_PSK; needsTextUpdate = true; break;
+                        case SDLK_4: current_mod_type = MOD_QAM; needsTextUpdate = true; break;
+                        case SDLK_5: current_mod_type = MOD_APSK; clamp_order_to_modulation(); needsTextUpdate = true; break;
                     }
                 }
                 switch (e.key.keysym.sym) {
                     case SDLK_h: showHelpScreen = !showHelpScreen; needsTextUpdate = true; break;
                     case SDLK_b:
-                        if (e.key.keysym.mod & KMOD_SHIFT) { rolloff_factor += 0.05; } else { rolloff_factor -= 0.05; }
-                        if (rolloff_factor > 1.0) rolloff_factor = 1.0;
-                        if (rolloff_factor < 0.0) rolloff_factor = 0.0;
+                        if (pulse_shape == PULSE_GAUSSIAN) {
+                            if (e.key.keysym.mod & KMOD_SHIFT) { gaussian_bt += 0.05; } else { gaussian_bt -= 0.05; }
+                            if (gaussian_bt > 1.0) gaussian_bt = 1.0;
+                            if (gaussian_bt < 0.1) gaussian_bt = 0.1;
+                        } else {
+                            if (e.key.keysym.mod & KMOD_SHIFT) { rolloff_factor += 0.05; } else { rolloff_factor -= 0.05; }
+                            if (rolloff_factor > 1.0) rolloff_factor = 1.0;
+                            if (rolloff_factor < 0.0) rolloff_factor = 0.0;
+                        }
+                        needsTextUpdate = true; break;
+                    case SDLK_g:
+                        pulse_shape = (pulse_shape + 1) % (PULSE_RECTANGULAR + 1);
+                        needsTextUpdate = true; break;
+                    case SDLK_k:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { pulse_span++; } else { pulse_span--; }
+                        if (pulse_span < 1) pulse_span = 1;
+                        if (pulse_span > PULSE_SHAPER_MAX_SPAN) pulse_span = PULSE_SHAPER_MAX_SPAN;
                         needsTextUpdate = true; break;
                     case SDLK_n:
                         if (e.key.keysym.mod & KMOD_SHIFT) { snr_db += 1.0; } else { snr_db -= 1.0; }
@@ -118,20 +289,79 @@ void main_loop() {
                     case SDLK_m:
                         if (e.key.keysym.mod & KMOD_SHIFT) { bitsPerSymbol++; } else { bitsPerSymbol--; }
                         if (bitsPerSymbol < 1) bitsPerSymbol = 1;
+                        if (bitsPerSymbol > CONSTELLATION_MAX_BITS) bitsPerSymbol = CONSTELLATION_MAX_BITS;
+                        clamp_order_to_modulation();
                         needsTextUpdate = true; break;
                     case SDLK_p:
                         if (e.key.keysym.mod & KMOD_SHIFT) { pixelsPerBit += 2; } else { pixelsPerBit -= 2; }
                         if (pixelsPerBit < 4) pixelsPerBit = 4;
                         needsTextUpdate = true; break;
                     case SDLK_SPACE: needsAngleUpdate = !needsAngleUpdate; break;
-                    case SDLK_j: time_offset -= 0.1; if (time_offset < 0) time_offset = 0; break;
-                    case SDLK_l: time_offset += 0.1; break;
+                    case SDLK_j: scroll_by(-0.1); break;
+                    case SDLK_l: scroll_by(0.1); break;
+                    case SDLK_MINUS:
+                    case SDLK_EQUALS:
+                        // Time domain zoom, from 64 samples per pixel to 16
+                        // pixels per sample
+                        if (e.key.keysym.sym == SDLK_EQUALS) { pixels_per_second *= 2.0; } else { pixels_per_second /= 2.0; }
+                        if (pixels_per_second < sampling_rate / 64.0) pixels_per_second = sampling_rate / 64.0;
+                        if (pixels_per_second > sampling_rate * 16.0) pixels_per_second = sampling_rate * 16.0;
+                        needsTextUpdate = true; break;
                     case SDLK_0:
-                        frequency = 300.0; amplitude = 100.0; snr_db = 100.0; pixelsPerBit = 50;
-                        rolloff_factor = 0.35; bitsPerSymbol = 1; time_offset = 0.0;
+                        frequency = 300.0; amplitude = 100.0; snr_db = 100.0; pixelsPerBit = 50; noise_seed = NOISE_DEFAULT_SEED;
+                        pixels_per_second = 500.0; rolloff_factor = 0.35; bitsPerSymbol = 1; reset_sample_clock();
+                        pulse_shape = PULSE_RAISED_COSINE; pulse_span = PULSE_SHAPER_SPAN; gaussian_bt = 0.5;
+                        multipath_profile = MULTIPATH_NONE; cfo_hz = 0.0; phase_noise_deg = 0.0;
+                        dc_offset = 0.0; iq_gain_db = 0.0; iq_phase_deg = 0.0; fading_model = FADING_NONE; doppler_hz = 1.0;
+                        clamp_order_to_modulation();
+                        needsTextUpdate = true; break;
+                    case SDLK_o:
+                        carrier_precision = (carrier_precision + 1) % (NCO_PRECISION_DDS_LUT + 1);
+                        needsTextUpdate = true; break;
+                    case SDLK_x:
+                        sample_precision = (sample_precision == SAMPLE_PRECISION_DOUBLE) ? SAMPLE_PRECISION_SINGLE : SAMPLE_PRECISION_DOUBLE;
+                        needsTextUpdate = true; break;
+                    case SDLK_t:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { export_threads++; } else { export_threads--; }
+                        if (export_threads < 0) export_threads = 0;
+                        needsTextUpdate = true; break;
+                    case SDLK_d:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { noise_seed = NOISE_DEFAULT_SEED; } else { noise_seed++; }
+                        needsTextUpdate = true; break;
+                    case SDLK_u:
+                        multipath_profile = (multipath_profile + 1) % MULTIPATH_PROFILE_COUNT;
+                        needsTextUpdate = true; break;
+                    case SDLK_c:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { cfo_hz += 1.0; } else { cfo_hz -= 1.0; }
+                        needsTextUpdate = true; break;
+                    case SDLK_v:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { phase_noise_deg += 1.0; } else { phase_noise_deg -= 1.0; }
+                        if (phase_noise_deg < 0.0) phase_noise_deg = 0.0;
+                        needsTextUpdate = true; break;
+                    case SDLK_z:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { dc_offset += 0.05; } else { dc_offset -= 0.05; }
+                        if (fabs(dc_offset) < 1e-9) dc_offset = 0.0;
                         needsTextUpdate = true; break;
-                    case SDLK_r: time_offset = 0; break;
-                    case SDLK_s: export_waveform(activeMessage, activeMessageLength, current_mod_type); break;
+                    case SDLK_y:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { iq_gain_db += 0.5; } else { iq_gain_db -= 0.5; }
+                        needsTextUpdate = true; break;
+                    case SDLK_q:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { iq_phase_deg += 1.0; } else { iq_phase_deg -= 1.0; }
+                        needsTextUpdate = true; break;
+                    case SDLK_f:
+                        if (current_view == VIEW_POWER_SPECTRUM) break; // F sizes the FFT there
+                        step_export_rate(e.key.keysym.mod & KMOD_SHIFT ? 1 : -1);
+                        needsTextUpdate = true; break;
+                    case SDLK_a:
+                        fading_model = (fading_model + 1) % FADING_MODEL_COUNT;
+                        needsTextUpdate = true; break;
+                    case SDLK_w:
+                        if (e.key.keysym.mod & KMOD_SHIFT) { doppler_hz += 0.5; } else { doppler_hz -= 0.5; }
+                        if (doppler_hz < 0.0) doppler_hz = 0.0;
+                        needsTextUpdate = true; break;
+                    case SDLK_r: reset_sample_clock(); break;
+                    case SDLK_s: update_signal(false); export_waveform(&waveform); break;
+                    case SDLK_i: load_payload(); needsTextUpdate = true; break;
                 }
             }
             if (!showHelpScreen) {
@@ -141,6 +371,17 @@ void main_loop() {
                             case SDLK_1: current_window_type = WINDOW_HANN; needsTextUpdate = true; break;
                             case SDLK_2: current_window_type = WINDOW_HAMMING; needsTextUpdate = true; break;
                             case SDLK_3: current_window_type = WINDOW_RECTANGULAR; needsTextUpdate = true; break;
+                            case SDLK_4:
+                                spectrum_averaging = (spectrum_averaging + 1) % (SPECTRUM_AVERAGE_MESSAGE + 1);
+                                needsTextUpdate = true; break;
+                            case SDLK_5:
+                                spectrum_overlap += 0.25;
+                                if (spectrum_overlap > 0.75) spectrum_overlap = 0.0;
+                                needsTextUpdate = true; break;
+                            case SDLK_6:
+                                spectrum_segments *= 2;
+                                if (spectrum_segments > 64) spectrum_segments = 2;
+                                needsTextUpdate = true; break;
                         }
                     }
                     switch (e.key.keysym.sym) {
@@ -166,6 +407,8 @@ void main_loop() {
                             } else { // Decrease FFT size
                                 fft_size /= 2;
                             }
+                            if (fft_size < SPECTRUM_MIN_FFT) fft_size = SPECTRUM_MIN_FFT;
+                            if (fft_size > SPECTRUM_MAX_FFT) fft_size = SPECTRUM_MAX_FFT;
                             needsTextUpdate = true;
                             break;
                         case SDLK_e:
@@ -194,8 +437,10 @@ void main_loop() {
                 switch (e.key.keysym.sym) {
                     case SDLK_RETURN:
                         strcpy(activeMessage, inputText); activeMessageLength = inputTextLength;
+                        payload_close(&activePayload);
+                        update_signal(true);
                         inputText[0] = '\0'; inputTextLength = 0;
-                        time_offset = 0; needsTextUpdate = true; break;
+                        reset_sample_clock(); needsTextUpdate = true; break;
                     case SDLK_BACKSPACE:
                         if (inputTextLength > 0) { inputText[--inputTextLength] = '\0'; }
                         needsTextUpdate = true; break;
@@ -206,20 +451,42 @@ void main_loop() {
 
     if (needsTextUpdate) {
         char buffer_l1[256], buffer_l2[256], buffer_mode[256];
-        const char* mod_str = (current_mod_type == MOD_ASK) ? "ASK" : (current_mod_type == MOD_FSK) ? "FSK" : "PSK";
+        const char* mod_str = modulation_name(current_mod_type);
         int mod_ord = 1 << bitsPerSymbol;
         char mod_full_str[32];
         if(mod_ord == 2 && current_mod_type == MOD_PSK) sprintf(mod_full_str, "BPSK");
         else if(mod_ord == 4 && current_mod_type == MOD_PSK) sprintf(mod_full_str, "QPSK");
         else sprintf(mod_full_str, "%d-%s", mod_ord, mod_str);
         
-        snprintf(buffer_l1, sizeof(buffer_l1), "A:%.0f F:%.0f %s", amplitude, frequency, mod_full_str);
-        snprintf(buffer_l2, sizeof(buffer_l2), "px/bit:%d SNR:%.0fdB Roll-off:%.2f, Fs:%.f Hz", pixelsPerBit, snr_db, rolloff_factor, sampling_rate);        
+        char pulse_str[32];
+        if (pulse_shape == PULSE_GAUSSIAN) snprintf(pulse_str, sizeof(pulse_str), "%s BT:%.2f", pulse_shape_name(pulse_shape), gaussian_bt);
+        else snprintf(pulse_str, sizeof(pulse_str), "%s", pulse_shape_name(pulse_shape));
+
+        snprintf(buffer_l1, sizeof(buffer_l1), "A:%.0f F:%.0f %s Pulse:%s/%d", amplitude, frequency, mod_full_str, pulse_str, pulse_span);
+        if (multipath_profile != MULTIPATH_NONE || cfo_hz != 0.0 || phase_noise_deg > 0.0 || dc_offset != 0.0 ||
+            iq_gain_db != 0.0 || iq_phase_deg != 0.0 || fading_model != FADING_NONE) {
+            char channel_buffer[128];
+            snprintf(channel_buffer, sizeof(channel_buffer), " Ch:%s CFO:%.0fHz PN:%.0fdeg DC:%.2f IQ:%.1fdB/%.0fdeg",
+                     multipath_profile_name(multipath_profile), cfo_hz, phase_noise_deg, dc_offset, iq_gain_db, iq_phase_deg);
+            strncat(buffer_l1, channel_buffer, sizeof(buffer_l1) - strlen(buffer_l1) - 1);
+            if (fading_model != FADING_NONE) {
+                snprintf(channel_buffer, sizeof(channel_buffer), " Fading:%s %.1fHz", fading_model_name(fading_model), doppler_hz);
+                strncat(buffer_l1, channel_buffer, sizeof(buffer_l1) - strlen(buffer_l1) - 1);
+            }
+        }
+        char threads_str[16];
+        if (export_threads == 0) snprintf(threads_str, sizeof(threads_str), "auto");
+        else snprintf(threads_str, sizeof(threads_str), "%d", export_threads);
+        char rate_str[16];
+        if (export_rate == 0.0) snprintf(rate_str, sizeof(rate_str), "native");
+        else snprintf(rate_str, sizeof(rate_str), "%.f Hz", export_rate);
+
+        snprintf(buffer_l2, sizeof(buffer_l2), "Sps:%d Zoom:%.0fpx/s SNR:%.0fdB Seed:%llu Roll-off:%.2f, Fs:%.f Hz, NCO:%s/%s, Export threads:%s rate:%s", pixelsPerBit, pixels_per_second, snr_db, (unsigned long long)noise_seed, rolloff_factor, sampling_rate, nco_precision_name(carrier_precision), sample_precision == SAMPLE_PRECISION_SINGLE ? "f32" : "f64", threads_str, rate_str);        
         snprintf(buffer_mode, sizeof(buffer_mode), "Mode: %s (Press TAB to switch)", current_mode == MODE_TYPING ? "Typing" : "Command");
 
         if (current_view == VIEW_POWER_SPECTRUM && hovered_power > -990.0) {
             char hover_buffer[128];
-            snprintf(hover_buffer, sizeof(hover_buffer), "  [%.1f Hz: %.1f dB]", hovered_frequency, hovered_power);
+            snprintf(hover_buffer, sizeof(hover_buffer), "  [%.1f Hz: %.1f dB/Hz]", hovered_frequency, hovered_power);
             // Append it to the first status line
             strncat(buffer_l1, hover_buffer, sizeof(buffer_l1) - strlen(buffer_l1) - 1);
         }
@@ -244,8 +511,16 @@ void main_loop() {
         switch (current_view) {
             case VIEW_POWER_SPECTRUM: {
                 const char* window_str = (current_window_type == WINDOW_HANN) ? "HANN" : (current_window_type == WINDOW_HAMMING) ? "HAMMING" : "RECTANGULAR";
-                snprintf(buffer_l2, sizeof(buffer_l2), "px/bit:%d SNR:%.0fdB Roll-off:%.2f, Fs:%.f Hz, FFT:%d, TRANSFORM:^%d", pixelsPerBit, snr_db, rolloff_factor, sampling_rate, fft_size, spectrum_power);   
-                snprintf(buffer_mode, sizeof(buffer_mode), "Mode: %s (Press TAB to switch), [WINDOW TYPE: %s]", current_mode == MODE_TYPING ? "Typing" : "Command", window_str);
+                snprintf(buffer_l2, sizeof(buffer_l2), "Sps:%d SNR:%.0fdB Roll-off:%.2f, Fs:%.f Hz, FFT:%d, TRANSFORM:^%d", pixelsPerBit, snr_db, rolloff_factor, sampling_rate, fft_size, spectrum_power);   
+                char averaging_str[64];
+                if (spectrum_averaging == SPECTRUM_SINGLE) {
+                    snprintf(averaging_str, sizeof(averaging_str), "SINGLE");
+                } else if (spectrum_averaging == SPECTRUM_AVERAGE_VIEW) {
+                    snprintf(averaging_str, sizeof(averaging_str), "WELCH x%d, %.0f%% OVERLAP", spectrum_segments, spectrum_overlap * 100.0);
+                } else {
+                    snprintf(averaging_str, sizeof(averaging_str), "WELCH OVER MESSAGE, %.0f%% OVERLAP", spectrum_overlap * 100.0);
+                }
+                snprintf(buffer_mode, sizeof(buffer_mode), "Mode: %s (Press TAB to switch), [WINDOW TYPE: %s] [AVERAGING: %s]", current_mode == MODE_TYPING ? "Typing" : "Command", window_str, averaging_str);
                 update_text_object(&status_line2, buffer_l2);
                 update_text_object(&mode_indicator_text, buffer_mode);
                 break;
@@ -267,6 +542,12 @@ void main_loop() {
         SDL_RenderFillRect(renderer, &overlayRect);
         SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 
+        // Growth of the frame workspace, to spot a long-running display
+        // that keeps allocating
+        char workspace_line[96];
+        snprintf(workspace_line, sizeof(workspace_line), "Frame workspace: %zu KB, %lld allocations",
+                 frame_workspace.capacity / 1024, (long long)frame_workspace.allocations);
+
         const char* help_lines[] = {
             "--- CONTROLS (ANY MODE) ---",
             "Enter     - Modulate Typed Message",
@@ -276,25 +557,41 @@ void main_loop() {
             " ",
             "--- CONTROLS (COMMAND MODE) ---",
             "H         - Toggle this Help Screen",
-            "1,2,3     - Switch Modulation (ASK, FSK, PSK)",
+            "1-5       - Switch Modulation (ASK, FSK, PSK, QAM, APSK)",
             "CTRL+1,2,3     - Switch View (Time Domain, IQ Plot, Power Spectrum)",
             "M/Shift+M - Decrease/Increase Modulation Order (BPSK, QPSK...)",
             "N/Shift+N - Decrease/Increase SNR",
-            "B/Shift+B - Decrease/Increase Roll-off Factor",
-            "P/Shift+P - Decrease/Increase Pixels per Bit",
-            "F/Shift+F - Decrease/Increase Sampling Rate (CANNOT CHANGE FOR THE TIME BEING)",
+            "B/Shift+B - Decrease/Increase Roll-off Factor (BT for Gaussian)",
+            "G         - Cycle Pulse Shape (RC, RRC, Gaussian, Rectangular)",
+            "K/Shift+K - Decrease/Increase Pulse Span in Symbols",
+            "P/Shift+P - Decrease/Increase Samples per Symbol",
+            "F/Shift+F - Decrease/Increase Export Sample Rate (Resampled from the Sampling Rate)",
             "J/L       - Scroll Left/Right through Signal",
+            "-/=       - Zoom Time Domain Out/In",
             "R         - Reset Scroll to Start",
             "Space     - Pause/Resume Scrolling",
+            "O         - Cycle Carrier NCO Precision (LIBM, LUT, DDS)",
+            "X         - Toggle Single/Double Precision Generation",
             "0 (zero)  - Reset All Waveform Parameters",
             "S         - Save Waveform as .32fl file",
+            "I         - Load a Payload File (Enter returns to the typed message)",
+            "T/Shift+T - Decrease/Increase Export Threads (0 = one per CPU)",
+            "D/Shift+D - Next Noise Seed/Back to the Default Seed",
+            "U         - Cycle Multipath Profile (None, Two-Ray, Three-Ray, Dense)",
+            "C/V/Z     - Decrease Carrier Offset/Phase Noise/DC Offset (Shift to Increase)",
+            "Y/Q       - Decrease IQ Gain/Phase Imbalance (Shift to Increase)",
+            "A         - Cycle Fading over the Multipath Taps (None, Rayleigh, Rician)",
+            "W/Shift+W - Decrease/Increase Doppler Shift of the Fading",
             " ",
             "--- CONTROLS (POWER SPECTRUM IN COMMAND MODE) ---",
             "Arrows,    - Zoom & Move",
             "SHIFT+1,2,3 - Switch estimation type (HANN, HAMMING, RECTANGULAR)",
+            "SHIFT+4    - Cycle Averaging (Single, Welch from the View, Welch over the Message)",
+            "SHIFT+5,6  - Cycle Welch Overlap (0-75%) and Segments from the View (2-64)",
             "E/Shift+E  - Decrease/Increase Power of Transform (e.g. 2, 4, 8 ...)",
             "F/Shift+F  - Decrease/Increase FFT Value",
             "",
+            workspace_line,
             NULL
         };
         int y_pos = 100;
@@ -304,15 +601,17 @@ void main_loop() {
             y_pos += status_line1.rect.h + 5;
         }
     } else {
+        update_signal(false);
+
         switch (current_view) {
             case VIEW_TIME_DOMAIN:
-                draw_time_domain_view(renderer, activeMessage, activeMessageLength, current_mod_type);
+                draw_time_domain_view(renderer, &waveform);
                 break;
             case VIEW_IQ_PLOT:
-                draw_iq_plot(renderer, activeMessage, activeMessageLength, current_mod_type);
+                draw_iq_plot(renderer, &waveform);
                 break;
             case VIEW_POWER_SPECTRUM:
-                calculate_and_draw_spectrum(renderer, activeMessage, activeMessageLength, current_mod_type, current_window_type, current_view, mouse_x);
+                calculate_and_draw_spectrum(renderer, &waveform, current_window_type, current_view, mouse_x);
                 break;
         }
         draw_text_object(&status_line1, 10, 10);
@@ -325,7 +624,7 @@ void main_loop() {
     SDL_RenderPresent(renderer);
 
     if (needsAngleUpdate && !showHelpScreen) {
-        time_offset += 1.0 / 60.0;
+        scroll_by(1.0 / 60.0);
     }
 
     #ifndef __EMSCRIPTEN__
@@ -365,6 +664,14 @@ int main(int argc, char* argv[]) {
     input_text_display = create_text_object(renderer, font_size_20, (SDL_Color){200, 200, 20, 255});
 
     SDL_StartTextInput();
+    nco_init_tables();
+    noise_init_tables();
+    mod_kernels_init();
+    printf("Modulation kernels: %s\n", mod_kernels_get()->name);
+    fft_kernels_init();
+    printf("FFT kernels: %s\n", fft_kernels_get()->name);
+    // One thread per CPU for the spectrum and exports, started once
+    parallel_start(0);
 
     #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop(main_loop, 0, 1);
@@ -381,6 +688,15 @@ int main(int argc, char* argv[]) {
     destroy_text_object(&mode_indicator_text);
     destroy_text_object(&input_text_display);
     destroy_text_object(&help_prompt_text);
+    waveform_free(&waveform);
+    symbol_table_free(&activeSymbols);
+    payload_close(&activePayload);
+    pulse_shaper_free_cache();
+    constellation_free_tables();
+    time_domain_free_cache();
+    spectrum_free_cache();
+    workspace_free(&frame_workspace);
+    parallel_stop();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     TTF_Quit();
@@ -0,0 +1,472 @@
+#include "mod_kernels.h"
+#include <stddef.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__) && (defined(__GNUC__) || defined(__clang__))
+#define MOD_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && !defined(__EMSCRIPTEN__)
+#define MOD_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// --- Scalar reference ---
+
+static void axpy_scalar(double* y, const double* x, double a, int n) {
+    for (int i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+static void mix_iq_scalar(double* out, const double* in_phase, const double* quadrature,
+                          const double* carrier_cos, const double* carrier_sin, double amplitude, int n) {
+    for (int i = 0; i < n; ++i) {
+        out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+    }
+}
+
+static void mix_real_scalar(double* out, const double* envelope, const double* carrier, double amplitude, int n) {
+    for (int i = 0; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+static void scale_scalar(double* y, double a, int n) {
+    for (int i = 0; i < n; ++i) y[i] *= a;
+}
+
+static void axpy_f32_scalar(float* y, const float* x, float a, int n) {
+    for (int i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+static void mix_iq_f32_scalar(float* out, const float* in_phase, const float* quadrature,
+                              const float* carrier_cos, const float* carrier_sin, float amplitude, int n) {
+    for (int i = 0; i < n; ++i) {
+        out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+    }
+}
+
+static void mix_real_f32_scalar(float* out, const float* envelope, const float* carrier, float amplitude, int n) {
+    for (int i = 0; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+static void scale_f32_scalar(float* y, float a, int n) {
+    for (int i = 0; i < n; ++i) y[i] *= a;
+}
+
+static const ModKernels kernels_scalar = {
+    "scalar", axpy_scalar, mix_iq_scalar, mix_real_scalar, scale_scalar,
+    axpy_f32_scalar, mix_iq_f32_scalar, mix_real_f32_scalar, scale_f32_scalar
+};
+
+#ifdef MOD_KERNELS_X86
+
+// --- SSE2 (2 doubles) ---
+
+__attribute__((target("sse2")))
+static void axpy_sse2(double* y, const double* x, double a, int n) {
+    __m128d va = _mm_set1_pd(a);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("sse2")))
+static void mix_iq_sse2(double* out, const double* in_phase, const double* quadrature,
+                        const double* carrier_cos, const double* carrier_sin, double amplitude, int n) {
+    __m128d vamp = _mm_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d ic = _mm_mul_pd(_mm_loadu_pd(in_phase + i), _mm_loadu_pd(carrier_cos + i));
+        __m128d qs = _mm_mul_pd(_mm_loadu_pd(quadrature + i), _mm_loadu_pd(carrier_sin + i));
+        _mm_storeu_pd(out + i, _mm_mul_pd(vamp, _mm_sub_pd(ic, qs)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("sse2")))
+static void mix_real_sse2(double* out, const double* envelope, const double* carrier, double amplitude, int n) {
+    __m128d vamp = _mm_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_mul_pd(vamp, _mm_loadu_pd(envelope + i)), _mm_loadu_pd(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("sse2")))
+static void scale_sse2(double* y, double a, int n) {
+    __m128d va = _mm_set1_pd(a);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(y + i, _mm_mul_pd(_mm_loadu_pd(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+// --- SSE2 (4 floats) ---
+
+__attribute__((target("sse2")))
+static void axpy_f32_sse2(float* y, const float* x, float a, int n) {
+    __m128 va = _mm_set1_ps(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("sse2")))
+static void mix_iq_f32_sse2(float* out, const float* in_phase, const float* quadrature,
+                            const float* carrier_cos, const float* carrier_sin, float amplitude, int n) {
+    __m128 vamp = _mm_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 ic = _mm_mul_ps(_mm_loadu_ps(in_phase + i), _mm_loadu_ps(carrier_cos + i));
+        __m128 qs = _mm_mul_ps(_mm_loadu_ps(quadrature + i), _mm_loadu_ps(carrier_sin + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(vamp, _mm_sub_ps(ic, qs)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("sse2")))
+static void mix_real_f32_sse2(float* out, const float* envelope, const float* carrier, float amplitude, int n) {
+    __m128 vamp = _mm_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_mul_ps(vamp, _mm_loadu_ps(envelope + i)), _mm_loadu_ps(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("sse2")))
+static void scale_f32_sse2(float* y, float a, int n) {
+    __m128 va = _mm_set1_ps(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(y + i, _mm_mul_ps(_mm_loadu_ps(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+static const ModKernels kernels_sse2 = {
+    "sse2", axpy_sse2, mix_iq_sse2, mix_real_sse2, scale_sse2,
+    axpy_f32_sse2, mix_iq_f32_sse2, mix_real_f32_sse2, scale_f32_sse2
+};
+
+// --- AVX2 + FMA (4 doubles) ---
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(double* y, const double* x, double a, int n) {
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void mix_iq_avx2(double* out, const double* in_phase, const double* quadrature,
+                        const double* carrier_cos, const double* carrier_sin, double amplitude, int n) {
+    __m256d vamp = _mm256_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d qs = _mm256_mul_pd(_mm256_loadu_pd(quadrature + i), _mm256_loadu_pd(carrier_sin + i));
+        __m256d v = _mm256_fmsub_pd(_mm256_loadu_pd(in_phase + i), _mm256_loadu_pd(carrier_cos + i), qs);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(vamp, v));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void mix_real_avx2(double* out, const double* envelope, const double* carrier, double amplitude, int n) {
+    __m256d vamp = _mm256_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_mul_pd(vamp, _mm256_loadu_pd(envelope + i)), _mm256_loadu_pd(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void scale_avx2(double* y, double a, int n) {
+    __m256d va = _mm256_set1_pd(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(y + i, _mm256_mul_pd(_mm256_loadu_pd(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+// --- AVX2 + FMA (8 floats) ---
+
+__attribute__((target("avx2,fma")))
+static void axpy_f32_avx2(float* y, const float* x, float a, int n) {
+    __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void mix_iq_f32_avx2(float* out, const float* in_phase, const float* quadrature,
+                            const float* carrier_cos, const float* carrier_sin, float amplitude, int n) {
+    __m256 vamp = _mm256_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 qs = _mm256_mul_ps(_mm256_loadu_ps(quadrature + i), _mm256_loadu_ps(carrier_sin + i));
+        __m256 v = _mm256_fmsub_ps(_mm256_loadu_ps(in_phase + i), _mm256_loadu_ps(carrier_cos + i), qs);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(vamp, v));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("avx2,fma")))
+static void mix_real_f32_avx2(float* out, const float* envelope, const float* carrier, float amplitude, int n) {
+    __m256 vamp = _mm256_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_mul_ps(vamp, _mm256_loadu_ps(envelope + i)), _mm256_loadu_ps(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("avx2,fma")))
+static void scale_f32_avx2(float* y, float a, int n) {
+    __m256 va = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_loadu_ps(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+static const ModKernels kernels_avx2 = {
+    "avx2", axpy_avx2, mix_iq_avx2, mix_real_avx2, scale_avx2,
+    axpy_f32_avx2, mix_iq_f32_avx2, mix_real_f32_avx2, scale_f32_avx2
+};
+
+// --- AVX-512F (8 doubles) ---
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(double* y, const double* x, double a, int n) {
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("avx512f")))
+static void mix_iq_avx512(double* out, const double* in_phase, const double* quadrature,
+                          const double* carrier_cos, const double* carrier_sin, double amplitude, int n) {
+    __m512d vamp = _mm512_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d qs = _mm512_mul_pd(_mm512_loadu_pd(quadrature + i), _mm512_loadu_pd(carrier_sin + i));
+        __m512d v = _mm512_fmsub_pd(_mm512_loadu_pd(in_phase + i), _mm512_loadu_pd(carrier_cos + i), qs);
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(vamp, v));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("avx512f")))
+static void mix_real_avx512(double* out, const double* envelope, const double* carrier, double amplitude, int n) {
+    __m512d vamp = _mm512_set1_pd(amplitude);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_mul_pd(vamp, _mm512_loadu_pd(envelope + i)), _mm512_loadu_pd(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("avx512f")))
+static void scale_avx512(double* y, double a, int n) {
+    __m512d va = _mm512_set1_pd(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm512_storeu_pd(y + i, _mm512_mul_pd(_mm512_loadu_pd(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+// --- AVX-512F (16 floats) ---
+
+__attribute__((target("avx512f")))
+static void axpy_f32_avx512(float* y, const float* x, float a, int n) {
+    __m512 va = _mm512_set1_ps(a);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+__attribute__((target("avx512f")))
+static void mix_iq_f32_avx512(float* out, const float* in_phase, const float* quadrature,
+                              const float* carrier_cos, const float* carrier_sin, float amplitude, int n) {
+    __m512 vamp = _mm512_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 qs = _mm512_mul_ps(_mm512_loadu_ps(quadrature + i), _mm512_loadu_ps(carrier_sin + i));
+        __m512 v = _mm512_fmsub_ps(_mm512_loadu_ps(in_phase + i), _mm512_loadu_ps(carrier_cos + i), qs);
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(vamp, v));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+__attribute__((target("avx512f")))
+static void mix_real_f32_avx512(float* out, const float* envelope, const float* carrier, float amplitude, int n) {
+    __m512 vamp = _mm512_set1_ps(amplitude);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_mul_ps(vamp, _mm512_loadu_ps(envelope + i)), _mm512_loadu_ps(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+__attribute__((target("avx512f")))
+static void scale_f32_avx512(float* y, float a, int n) {
+    __m512 va = _mm512_set1_ps(a);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) _mm512_storeu_ps(y + i, _mm512_mul_ps(_mm512_loadu_ps(y + i), va));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+static const ModKernels kernels_avx512 = {
+    "avx512", axpy_avx512, mix_iq_avx512, mix_real_avx512, scale_avx512,
+    axpy_f32_avx512, mix_iq_f32_avx512, mix_real_f32_avx512, scale_f32_avx512
+};
+
+#endif // MOD_KERNELS_X86
+
+#ifdef MOD_KERNELS_NEON
+
+// --- NEON (2 doubles, AArch64 baseline) ---
+
+static void axpy_neon(double* y, const double* x, double a, int n) {
+    float64x2_t va = vdupq_n_f64(a);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), va, vld1q_f64(x + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+static void mix_iq_neon(double* out, const double* in_phase, const double* quadrature,
+                        const double* carrier_cos, const double* carrier_sin, double amplitude, int n) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t qs = vmulq_f64(vld1q_f64(quadrature + i), vld1q_f64(carrier_sin + i));
+        // vfmsq computes qs - I*cos, the negation of what we want
+        float64x2_t v = vfmsq_f64(qs, vld1q_f64(in_phase + i), vld1q_f64(carrier_cos + i));
+        vst1q_f64(out + i, vmulq_n_f64(vnegq_f64(v), amplitude));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+static void mix_real_neon(double* out, const double* envelope, const double* carrier, double amplitude, int n) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(out + i, vmulq_f64(vmulq_n_f64(vld1q_f64(envelope + i), amplitude), vld1q_f64(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+static void scale_neon(double* y, double a, int n) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) vst1q_f64(y + i, vmulq_n_f64(vld1q_f64(y + i), a));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+// --- NEON (4 floats) ---
+
+static void axpy_f32_neon(float* y, const float* x, float a, int n) {
+    float32x4_t va = vdupq_n_f32(a);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vfmaq_f32(vld1q_f32(y + i), va, vld1q_f32(x + i)));
+    }
+    for (; i < n; ++i) y[i] += a * x[i];
+}
+
+static void mix_iq_f32_neon(float* out, const float* in_phase, const float* quadrature,
+                            const float* carrier_cos, const float* carrier_sin, float amplitude, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t qs = vmulq_f32(vld1q_f32(quadrature + i), vld1q_f32(carrier_sin + i));
+        // vfmsq computes qs - I*cos, the negation of what we want
+        float32x4_t v = vfmsq_f32(qs, vld1q_f32(in_phase + i), vld1q_f32(carrier_cos + i));
+        vst1q_f32(out + i, vmulq_n_f32(vnegq_f32(v), amplitude));
+    }
+    for (; i < n; ++i) out[i] = amplitude * (in_phase[i] * carrier_cos[i] - quadrature[i] * carrier_sin[i]);
+}
+
+static void mix_real_f32_neon(float* out, const float* envelope, const float* carrier, float amplitude, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vmulq_n_f32(vld1q_f32(envelope + i), amplitude), vld1q_f32(carrier + i)));
+    }
+    for (; i < n; ++i) out[i] = amplitude * envelope[i] * carrier[i];
+}
+
+static void scale_f32_neon(float* y, float a, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(y + i, vmulq_n_f32(vld1q_f32(y + i), a));
+    for (; i < n; ++i) y[i] *= a;
+}
+
+static const ModKernels kernels_neon = {
+    "neon", axpy_neon, mix_iq_neon, mix_real_neon, scale_neon,
+    axpy_f32_neon, mix_iq_f32_neon, mix_real_f32_neon, scale_f32_neon
+};
+
+#endif // MOD_KERNELS_NEON
+
+// --- Dispatch ---
+
+static const ModKernels* active_kernels = NULL;
+
+static bool kernels_supported(const ModKernels* kernels) {
+    if (kernels == &kernels_scalar) return true;
+#ifdef MOD_KERNELS_X86
+    __builtin_cpu_init();
+    if (kernels == &kernels_sse2) return __builtin_cpu_supports("sse2");
+    if (kernels == &kernels_avx2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (kernels == &kernels_avx512) return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef MOD_KERNELS_NEON
+    if (kernels == &kernels_neon) return true;
+#endif
+    return false;
+}
+
+// Widest first
+static const ModKernels* const all_kernels[] = {
+#ifdef MOD_KERNELS_X86
+    &kernels_avx512, &kernels_avx2, &kernels_sse2,
+#endif
+#ifdef MOD_KERNELS_NEON
+    &kernels_neon,
+#endif
+    &kernels_scalar,
+};
+
+void mod_kernels_init(void) {
+    if (active_kernels != NULL) return;
+    for (size_t i = 0; i < sizeof(all_kernels) / sizeof(all_kernels[0]); ++i) {
+        if (kernels_supported(all_kernels[i])) {
+            active_kernels = all_kernels[i];
+            return;
+        }
+    }
+}
+
+const ModKernels* mod_kernels_get(void) {
+    mod_kernels_init();
+    return active_kernels;
+}
+
+bool mod_kernels_select(const char* name) {
+    for (size_t i = 0; i < sizeof(all_kernels) / sizeof(all_kernels[0]); ++i) {
+        if (strcmp(all_kernels[i]->name, name) == 0 && kernels_supported(all_kernels[i])) {
+            active_kernels = all_kernels[i];
+            return true;
+        }
+    }
+    return false;
+}
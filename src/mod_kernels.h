@@ -0,0 +1,37 @@
+#ifndef MOD_KERNELS_H
+#define MOD_KERNELS_H
+
+#include <stdbool.h>
+
+// Block kernels the modulator is built from. Every implementation computes
+// the same thing as the scalar one, which stays the reference; the vector
+// versions only differ in rounding where they use fused multiply-add.
+// The _f32 variants are the same operations in single precision, with
+// twice the lanes per vector.
+typedef struct {
+    const char* name;
+    // y[i] += a * x[i]; accumulates one pulse-shaper tap row
+    void (*axpy)(double* y, const double* x, double a, int n);
+    // out[i] = amplitude * (in_phase[i] * cos[i] - quadrature[i] * sin[i])
+    void (*mix_iq)(double* out, const double* in_phase, const double* quadrature,
+                   const double* carrier_cos, const double* carrier_sin, double amplitude, int n);
+    // out[i] = amplitude * envelope[i] * carrier[i]
+    void (*mix_real)(double* out, const double* envelope, const double* carrier, double amplitude, int n);
+    // y[i] *= a
+    void (*scale)(double* y, double a, int n);
+
+    void (*axpy_f32)(float* y, const float* x, float a, int n);
+    void (*mix_iq_f32)(float* out, const float* in_phase, const float* quadrature,
+                       const float* carrier_cos, const float* carrier_sin, float amplitude, int n);
+    void (*mix_real_f32)(float* out, const float* envelope, const float* carrier, float amplitude, int n);
+    void (*scale_f32)(float* y, float a, int n);
+} ModKernels;
+
+// Picks the widest instruction set the CPU supports. Safe to call again.
+void mod_kernels_init(void);
+const ModKernels* mod_kernels_get(void);
+// Forces an implementation by name ("scalar", "sse2", "avx2", "avx512",
+// "neon"). Returns false if it isn't available on this machine.
+bool mod_kernels_select(const char* name);
+
+#endif // MOD_KERNELS_H
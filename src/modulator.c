@@ -0,0 +1,707 @@
+#include "modulator.h"
+#include "nco.h"
+#include "mod_kernels.h"
+#include "parallel.h"
+#include "constellation.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool params_equal(const ModulatorParams* a, const ModulatorParams* b) {
+    return a->mod_type == b->mod_type &&
+           a->bits_per_symbol == b->bits_per_symbol &&
+           a->samples_per_symbol == b->samples_per_symbol &&
+           a->amplitude == b->amplitude &&
+           a->frequency == b->frequency &&
+           a->sampling_rate == b->sampling_rate &&
+           a->rolloff == b->rolloff &&
+           a->pulse_shape == b->pulse_shape &&
+           a->pulse_span == b->pulse_span &&
+           a->gaussian_bt == b->gaussian_bt &&
+           a->carrier_precision == b->carrier_precision &&
+           a->sample_precision == b->sample_precision;
+}
+
+int64_t modulator_total_samples(const ModulatorParams* params, const SymbolTable* symbols) {
+    if (symbols == NULL) return 0;
+    return symbols->count * params->samples_per_symbol;
+}
+
+struct Modulator {
+    ModulatorParams params;
+    const SymbolTable* symbols;
+    bool loop;
+    const ModKernels* kernels;
+    const Constellation* constellation;
+    int sps;
+    bool single; // renders in float; the _f32 buffers are used instead
+
+    // Pulse shaper taps (all but FSK), copied so the shaper cache can move on
+    int span;
+    int num_taps;
+    double* taps;
+    float* taps_f32;
+
+    // Impulses of symbols (next_symbol - span) .. (next_symbol + span); this
+    // is the filter history carried from one block to the next
+    double* window_I;
+    double* window_Q;
+
+    double* scratch;  // envelope I/Q and carrier sin/cos for one block
+    double* block;    // the most recent symbol period, for partial reads
+    float* scratch_f32;
+    float* block_f32;
+    int block_offset; // samples of 'block' already handed out
+
+    uint32_t carrier_increment;
+    uint32_t carrier_phase; // at the start of next_symbol
+    uint32_t fsk_phase;     // at the start of next_symbol
+    uint32_t fsk_base_increment; // tone for symbol value 0
+    uint32_t fsk_step_increment; // spacing between adjacent tones
+
+    int64_t total_samples; // -1 when looping forever
+    int64_t position;      // next sample next() hands out
+    int64_t next_symbol;   // symbol the next rendered block belongs to
+};
+
+static int symbol_value_at(const Modulator* mod, int64_t index, bool* present) {
+    int64_t count = mod->symbols->count;
+    if (mod->loop) {
+        index %= count;
+        if (index < 0) index += count;
+    } else if (index < 0 || index >= count) {
+        *present = false;
+        return 0;
+    }
+    *present = true;
+    return symbol_table_value(mod->symbols, index);
+}
+
+// Maps one symbol to its impulse. Symbols outside a non-looping message are
+// silent, which truncates the pulse tails at both ends.
+static void map_impulse(const Modulator* mod, int64_t index, double* impulse_I, double* impulse_Q) {
+    bool present;
+    int symbol_value = symbol_value_at(mod, index, &present);
+    if (!present) {
+        *impulse_I = 0.0;
+        *impulse_Q = 0.0;
+        return;
+    }
+    *impulse_I = mod->constellation->I[symbol_value];
+    *impulse_Q = mod->constellation->Q[symbol_value];
+}
+
+static void fill_window(Modulator* mod) {
+    for (int k = 0; k < mod->num_taps; ++k) {
+        map_impulse(mod, mod->next_symbol + k - mod->span, &mod->window_I[k], &mod->window_Q[k]);
+    }
+}
+
+// Tone v sits at frequency + v * frequency / 2. Building its increment as
+// base + v * step (instead of rounding each tone separately) makes the phase
+// at a symbol boundary linear in the running sum of symbol values.
+static uint32_t fsk_increment_for(const Modulator* mod, int symbol_value) {
+    return mod->fsk_base_increment + (uint32_t)symbol_value * mod->fsk_step_increment;
+}
+
+// Phase at the start of symbol k, in closed form:
+//   sps * (k * base + step * sum of values[0 .. k-1])   (mod 2^32)
+// The symbol table's checkpoints give the sum in bounded time; a looped
+// message adds whole laps of it.
+static uint32_t fsk_phase_at(const Modulator* mod, int64_t symbol) {
+    const SymbolTable* symbols = mod->symbols;
+    int64_t count = symbols->count;
+    uint32_t value_sum;
+    if (symbol >= count) {
+        // Past the end only happens when looping; a non-looping stream
+        // renders nothing there
+        value_sum = (uint32_t)(symbol / count) * symbols->total_sum + symbol_table_value_sum(symbols, symbol % count);
+    } else {
+        value_sum = symbol_table_value_sum(symbols, symbol);
+    }
+    uint32_t per_symbol = (uint32_t)symbol * mod->fsk_base_increment + value_sum * mod->fsk_step_increment;
+    return per_symbol * (uint32_t)mod->sps;
+}
+
+// Moves on to the next symbol, sliding the impulse window along with it
+static void advance_symbol(Modulator* mod) {
+    if (mod->params.mod_type != MOD_FSK) {
+        memmove(mod->window_I, mod->window_I + 1, (mod->num_taps - 1) * sizeof(double));
+        memmove(mod->window_Q, mod->window_Q + 1, (mod->num_taps - 1) * sizeof(double));
+        map_impulse(mod, mod->next_symbol + mod->span + 1, &mod->window_I[mod->num_taps - 1], &mod->window_Q[mod->num_taps - 1]);
+    }
+    mod->next_symbol++;
+}
+
+// Renders the sps samples of next_symbol into dst and advances to the next
+// symbol.
+static void render_block(Modulator* mod, double* dst) {
+    int sps = mod->sps;
+    const ModKernels* kernels = mod->kernels;
+
+    if (mod->params.mod_type == MOD_FSK) {
+        // One oscillator retuned at every symbol keeps the phase continuous
+        bool present;
+        int symbol_value = symbol_value_at(mod, mod->next_symbol, &present);
+        nco_fill(&mod->fsk_phase, fsk_increment_for(mod, symbol_value), mod->params.carrier_precision, dst, NULL, sps);
+        kernels->scale(dst, mod->params.amplitude, sps);
+    } else {
+        bool is_complex = mod->constellation->is_complex;
+        double* envelope_I = mod->scratch;
+        double* envelope_Q = mod->scratch + sps;
+        double* carrier_sin = mod->scratch + 2 * sps;
+        double* carrier_cos = mod->scratch + 3 * sps;
+
+        // Accumulate the shaper tap rows into the baseband envelope
+        memset(envelope_I, 0, sps * sizeof(double));
+        if (is_complex) memset(envelope_Q, 0, sps * sizeof(double));
+        for (int k = 0; k < mod->num_taps; ++k) {
+            const double* tap_row = mod->taps + k * sps;
+            if (mod->window_I[k] != 0.0) kernels->axpy(envelope_I, tap_row, mod->window_I[k], sps);
+            if (is_complex && mod->window_Q[k] != 0.0) kernels->axpy(envelope_Q, tap_row, mod->window_Q[k], sps);
+        }
+
+        // Then mix it onto the carrier
+        if (is_complex) {
+            nco_fill(&mod->carrier_phase, mod->carrier_increment, mod->params.carrier_precision, carrier_sin, carrier_cos, sps);
+            kernels->mix_iq(dst, envelope_I, envelope_Q, carrier_cos, carrier_sin, mod->params.amplitude, sps);
+        } else {
+            nco_fill(&mod->carrier_phase, mod->carrier_increment, mod->params.carrier_precision, carrier_sin, NULL, sps);
+            kernels->mix_real(dst, envelope_I, carrier_sin, mod->params.amplitude, sps);
+        }
+
+    }
+    advance_symbol(mod);
+}
+
+// Single-precision twin of render_block(). Impulses and the integer carrier
+// phase are shared with the double path; taps, envelope, carrier and mix
+// are float.
+static void render_block_f32(Modulator* mod, float* dst) {
+    int sps = mod->sps;
+    const ModKernels* kernels = mod->kernels;
+    float amplitude = (float)mod->params.amplitude;
+
+    if (mod->params.mod_type == MOD_FSK) {
+        bool present;
+        int symbol_value = symbol_value_at(mod, mod->next_symbol, &present);
+        nco_fill_f32(&mod->fsk_phase, fsk_increment_for(mod, symbol_value), mod->params.carrier_precision, dst, NULL, sps);
+        kernels->scale_f32(dst, amplitude, sps);
+    } else {
+        bool is_complex = mod->constellation->is_complex;
+        float* envelope_I = mod->scratch_f32;
+        float* envelope_Q = mod->scratch_f32 + sps;
+        float* carrier_sin = mod->scratch_f32 + 2 * sps;
+        float* carrier_cos = mod->scratch_f32 + 3 * sps;
+
+        memset(envelope_I, 0, sps * sizeof(float));
+        if (is_complex) memset(envelope_Q, 0, sps * sizeof(float));
+        for (int k = 0; k < mod->num_taps; ++k) {
+            const float* tap_row = mod->taps_f32 + k * sps;
+            if (mod->window_I[k] != 0.0) kernels->axpy_f32(envelope_I, tap_row, (float)mod->window_I[k], sps);
+            if (is_complex && mod->window_Q[k] != 0.0) kernels->axpy_f32(envelope_Q, tap_row, (float)mod->window_Q[k], sps);
+        }
+
+        if (is_complex) {
+            nco_fill_f32(&mod->carrier_phase, mod->carrier_increment, mod->params.carrier_precision, carrier_sin, carrier_cos, sps);
+            kernels->mix_iq_f32(dst, envelope_I, envelope_Q, carrier_cos, carrier_sin, amplitude, sps);
+        } else {
+            nco_fill_f32(&mod->carrier_phase, mod->carrier_increment, mod->params.carrier_precision, carrier_sin, NULL, sps);
+            kernels->mix_real_f32(dst, envelope_I, carrier_sin, amplitude, sps);
+        }
+    }
+    advance_symbol(mod);
+}
+
+// Renders the next symbol into the partial-read block
+static void render_buffered(Modulator* mod) {
+    if (mod->single) {
+        render_block_f32(mod, mod->block_f32);
+    } else {
+        render_block(mod, mod->block);
+    }
+    mod->block_offset = 0;
+}
+
+Modulator* modulator_create(const ModulatorParams* params, const SymbolTable* symbols, bool loop) {
+    if (symbols == NULL || symbols->count <= 0 || params->samples_per_symbol <= 0) return NULL;
+
+    Modulator* mod = (Modulator*)calloc(1, sizeof(Modulator));
+    if (mod == NULL) return NULL;
+
+    mod->params = *params;
+    mod->symbols = symbols;
+    mod->loop = loop;
+    mod->kernels = mod_kernels_get();
+    mod->sps = params->samples_per_symbol;
+    mod->single = params->sample_precision == SAMPLE_PRECISION_SINGLE;
+    mod->total_samples = loop ? -1 : modulator_total_samples(params, symbols);
+    mod->carrier_increment = nco_increment(params->frequency, params->sampling_rate);
+    mod->fsk_base_increment = nco_increment(params->frequency, params->sampling_rate);
+    mod->fsk_step_increment = nco_increment(params->frequency / 2.0, params->sampling_rate);
+
+    nco_init_tables();
+
+    if (params->mod_type != MOD_FSK) {
+        mod->constellation = constellation_get(params->mod_type, params->bits_per_symbol);
+        if (mod->constellation == NULL) {
+            modulator_destroy(mod);
+            return NULL;
+        }
+
+        double shape_param = (params->pulse_shape == PULSE_GAUSSIAN) ? params->gaussian_bt : params->rolloff;
+        const PulseShaper* shaper = pulse_shaper_get(params->pulse_shape, shape_param, mod->sps, params->pulse_span);
+        if (shaper == NULL) {
+            modulator_destroy(mod);
+            return NULL;
+        }
+        mod->span = shaper->span;
+        mod->num_taps = shaper->num_taps;
+        size_t tap_count = (size_t)shaper->num_taps * mod->sps;
+        mod->window_I = (double*)calloc(shaper->num_taps, sizeof(double));
+        mod->window_Q = (double*)calloc(shaper->num_taps, sizeof(double));
+        if (mod->single) {
+            mod->taps_f32 = (float*)malloc(tap_count * sizeof(float));
+            mod->scratch_f32 = (float*)malloc(4 * (size_t)mod->sps * sizeof(float));
+        } else {
+            mod->taps = (double*)malloc(tap_count * sizeof(double));
+            mod->scratch = (double*)malloc(4 * (size_t)mod->sps * sizeof(double));
+        }
+        if (mod->window_I == NULL || mod->window_Q == NULL ||
+            (mod->single ? mod->taps_f32 == NULL || mod->scratch_f32 == NULL : mod->taps == NULL || mod->scratch == NULL)) {
+            modulator_destroy(mod);
+            return NULL;
+        }
+        if (mod->single) {
+            for (size_t i = 0; i < tap_count; ++i) mod->taps_f32[i] = (float)shaper->taps[i];
+        } else {
+            memcpy(mod->taps, shaper->taps, tap_count * sizeof(double));
+        }
+    }
+
+    if (mod->single) {
+        mod->block_f32 = (float*)malloc(mod->sps * sizeof(float));
+    } else {
+        mod->block = (double*)malloc(mod->sps * sizeof(double));
+    }
+    if (mod->block == NULL && mod->block_f32 == NULL) {
+        modulator_destroy(mod);
+        return NULL;
+    }
+
+    modulator_seek(mod, 0);
+    return mod;
+}
+
+// Hands out 'count' buffered samples at out[at], converting if the caller
+// asked for the other precision
+static void copy_buffered(Modulator* mod, double* out, float* out_f32, int at, int count) {
+    if (mod->single) {
+        const float* src = mod->block_f32 + mod->block_offset;
+        if (out_f32 != NULL) memcpy(out_f32 + at, src, count * sizeof(float));
+        else for (int i = 0; i < count; ++i) out[at + i] = src[i];
+    } else {
+        const double* src = mod->block + mod->block_offset;
+        if (out != NULL) memcpy(out + at, src, count * sizeof(double));
+        else for (int i = 0; i < count; ++i) out_f32[at + i] = (float)src[i];
+    }
+    mod->block_offset += count;
+}
+
+static int next_samples(Modulator* mod, double* out, float* out_f32, int n) {
+    if (!mod->loop && mod->total_samples - mod->position < n) {
+        n = (int)(mod->total_samples - mod->position);
+    }
+
+    // Whole symbols go straight into the caller's buffer when it has the
+    // modulator's own precision
+    bool direct = mod->single ? out_f32 != NULL : out != NULL;
+    int written = 0;
+    while (written < n) {
+        int remaining = n - written;
+        if (mod->block_offset < mod->sps) {
+            int count = mod->sps - mod->block_offset;
+            if (count > remaining) count = remaining;
+            copy_buffered(mod, out, out_f32, written, count);
+            written += count;
+        } else if (direct && remaining >= mod->sps) {
+            if (mod->single) render_block_f32(mod, out_f32 + written);
+            else render_block(mod, out + written);
+            written += mod->sps;
+        } else {
+            render_buffered(mod);
+        }
+    }
+    mod->position += written;
+    return written;
+}
+
+// Writes up to n samples and returns how many were written; fewer than n
+// only at the end of a non-looping message.
+int modulator_next(Modulator* mod, double* buf, int n) {
+    return next_samples(mod, buf, NULL, n);
+}
+
+int modulator_next_f32(Modulator* mod, float* buf, int n) {
+    return next_samples(mod, NULL, buf, n);
+}
+
+// Repositions the stream in O(1). Carrier and FSK phase are recomputed from
+// the sample index, so a seek lands exactly where sequential generation would.
+void modulator_seek(Modulator* mod, int64_t sample) {
+    if (sample < 0) sample = 0;
+    if (!mod->loop && sample > mod->total_samples) sample = mod->total_samples;
+
+    int64_t symbol = sample / mod->sps;
+    int offset = (int)(sample % mod->sps);
+
+    mod->next_symbol = symbol;
+    mod->carrier_phase = (uint32_t)((uint64_t)symbol * mod->sps * mod->carrier_increment);
+    if (mod->params.mod_type == MOD_FSK) {
+        mod->fsk_phase = fsk_phase_at(mod, symbol);
+    } else {
+        fill_window(mod);
+    }
+
+    mod->block_offset = mod->sps; // Nothing buffered
+    if (offset > 0) {
+        render_buffered(mod);
+        mod->block_offset = offset;
+    }
+    mod->position = sample;
+}
+
+int64_t modulator_tell(const Modulator* mod) {
+    return mod->position;
+}
+
+void modulator_destroy(Modulator* mod) {
+    if (mod == NULL) return;
+    free(mod->taps);
+    free(mod->window_I);
+    free(mod->window_Q);
+    free(mod->scratch);
+    free(mod->block);
+    free(mod->taps_f32);
+    free(mod->scratch_f32);
+    free(mod->block_f32);
+    free(mod);
+}
+
+// Smallest slice worth handing to its own thread
+#define MIN_SAMPLES_PER_TASK 16384
+
+typedef struct {
+    Modulator** modulators;
+    const Channel* channel;
+    const Resampler* resampler;
+    int64_t start;
+    int count;
+    int per_task;
+    double* out;
+    float* out_f32;
+    WorkspaceSet* workspaces; // one per task, or NULL
+    bool failed; // set by any task that fails, so only with __atomic_store_n
+} RenderJob;
+
+// Renders samples [start, start + count) at the modulator's own rate,
+// through the channel unless it is NULL. The channel reads a margin of
+// input on either side; before the start of the message that is silence.
+// The input and the channel's scratch come from 'workspace', which the
+// caller releases.
+static bool render_native(Modulator* mod, const Channel* channel, int64_t start, double* out, int count,
+                          Workspace* workspace) {
+    int history = channel != NULL ? channel_history(channel) : 0;
+    int input_length = history + count + (channel != NULL ? channel_lookahead(channel) : 0);
+    double* input = channel != NULL ? workspace_doubles(workspace, input_length) : out;
+    if (input == NULL) return false;
+
+    int64_t input_start = start - history;
+    int silent = input_start < 0 ? (int)(-input_start < input_length ? -input_start : input_length) : 0;
+    for (int i = 0; i < silent; ++i) input[i] = 0.0;
+    modulator_seek(mod, input_start + silent);
+    int written = silent + modulator_next(mod, input + silent, input_length - silent);
+    for (int i = written; i < input_length; ++i) input[i] = 0.0;
+
+    if (channel == NULL) return true;
+    return channel_process(channel, start, input + history, out, count, workspace);
+}
+
+// Renders a slice through the channel and, if there is one, the
+// resampler, in which case 'start' and 'count' are at its output rate.
+// Scratch comes from 'workspace' and is given back before returning;
+// NULL allocates it for the call.
+static bool render_slice(Modulator* mod, const Channel* channel, const Resampler* resampler, int64_t start,
+                         double* out, float* out_f32, int count, Workspace* workspace) {
+    Workspace local = {0};
+    Workspace* scratch = workspace != NULL ? workspace : &local;
+    size_t mark = workspace_mark(scratch);
+    double* output = out != NULL ? out : workspace_doubles(scratch, count);
+    bool ok = output != NULL;
+
+    if (ok && resampler != NULL) {
+        int64_t input_first;
+        int input_count;
+        resampler_input_span(resampler, start, count, &input_first, &input_count);
+        double* input = workspace_doubles(scratch, input_count);
+        ok = input != NULL && render_native(mod, channel, input_first, input, input_count, scratch);
+        if (ok) resampler_process(resampler, start, input, input_first, output, count);
+    } else if (ok) {
+        ok = render_native(mod, channel, start, output, count, scratch);
+    }
+
+    if (ok && out_f32 != NULL) {
+        for (int i = 0; i < count; ++i) out_f32[i] = (float)output[i];
+    }
+    workspace_release(scratch, mark);
+    workspace_free(&local);
+    return ok;
+}
+
+// Every task seeks its own modulator to the start of its slice. Seeking is
+// exact, so the output doesn't depend on how the range was split.
+static void render_task(void* context, int task_index) {
+    RenderJob* job = (RenderJob*)context;
+    int begin = task_index * job->per_task;
+    int end = begin + job->per_task;
+    if (end > job->count) end = job->count;
+    Modulator* mod = job->modulators[task_index];
+
+    if (job->channel != NULL || job->resampler != NULL) {
+        if (!render_slice(mod, job->channel, job->resampler, job->start + begin,
+                          job->out != NULL ? job->out + begin : NULL,
+                          job->out_f32 != NULL ? job->out_f32 + begin : NULL, end - begin,
+                          job->workspaces != NULL ? &job->workspaces->items[task_index] : NULL)) {
+            __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+
+    modulator_seek(mod, job->start + begin);
+    if (job->out != NULL) {
+        int written = modulator_next(mod, job->out + begin, end - begin);
+        for (int i = begin + written; i < end; ++i) job->out[i] = 0.0;
+    } else {
+        int written = modulator_next_f32(mod, job->out_f32 + begin, end - begin);
+        for (int i = begin + written; i < end; ++i) job->out_f32[i] = 0.0f;
+    }
+}
+
+static bool render_range(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                         const Resampler* resampler, int64_t start, double* out, float* out_f32, int count, int threads,
+                         WorkspaceSet* workspaces) {
+    if (count <= 0) return true;
+    if (channel != NULL && channel_is_clean(channel)) channel = NULL;
+
+    int tasks = parallel_thread_count(threads);
+    int max_tasks = (count + MIN_SAMPLES_PER_TASK - 1) / MIN_SAMPLES_PER_TASK;
+    if (tasks > max_tasks) tasks = max_tasks;
+
+    // Modulators are created up front on this thread; the pulse shaper
+    // cache they read from isn't meant to be shared between threads
+    Modulator** modulators = (Modulator**)calloc(tasks, sizeof(Modulator*));
+    bool ok = modulators != NULL && (workspaces == NULL || workspace_set_reserve(workspaces, tasks));
+    for (int t = 0; ok && t < tasks; ++t) {
+        modulators[t] = modulator_create(params, symbols, false);
+        ok = modulators[t] != NULL;
+    }
+
+    if (ok) {
+        RenderJob job = { modulators, channel, resampler, start, count, (count + tasks - 1) / tasks, out, out_f32,
+                          workspaces, false };
+        parallel_run(render_task, &job, tasks, tasks);
+        ok = !__atomic_load_n(&job.failed, __ATOMIC_RELAXED);
+    }
+
+    for (int t = 0; modulators != NULL && t < tasks; ++t) modulator_destroy(modulators[t]);
+    free(modulators);
+    return ok;
+}
+
+// Renders samples [start, start + count) of the message, split across
+// 'threads' workers (0 for one per CPU). Samples past the end are silent.
+bool modulator_render_range(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                            int64_t start, double* out, int count, int threads, WorkspaceSet* workspaces) {
+    return render_range(params, symbols, channel, NULL, start, out, NULL, count, threads, workspaces);
+}
+
+bool modulator_render_range_f32(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                                int64_t start, float* out, int count, int threads, WorkspaceSet* workspaces) {
+    return render_range(params, symbols, channel, NULL, start, NULL, out, count, threads, workspaces);
+}
+
+bool modulator_render_resampled_f32(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                                    const Resampler* resampler, int64_t start, float* out, int count, int threads,
+                                    WorkspaceSet* workspaces) {
+    return render_range(params, symbols, channel, resampler, start, NULL, out, count, threads, workspaces);
+}
+
+typedef struct {
+    Modulator** modulators; // one per Welch task
+    const Channel* channel;
+    const Resampler* resampler;
+} SpectrumSource;
+
+static bool spectrum_source(void* context, int task, int64_t start, double* out, int count, Workspace* workspace) {
+    SpectrumSource* source = (SpectrumSource*)context;
+    return render_slice(source->modulators[task], source->channel, source->resampler, start, out, NULL, count,
+                        workspace);
+}
+
+bool modulator_power_spectrum(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                              const Resampler* resampler, const Welch* welch, int64_t start, int64_t count,
+                              double* psd, int threads, WorkspaceSet* workspaces) {
+    if (channel != NULL && channel_is_clean(channel)) channel = NULL;
+
+    // Created here for the same reason as in render_range
+    int tasks = welch_task_count(welch, count);
+    Modulator** modulators = (Modulator**)calloc(tasks, sizeof(Modulator*));
+    bool ok = modulators != NULL;
+    for (int t = 0; ok && t < tasks; ++t) {
+        modulators[t] = modulator_create(params, symbols, false);
+        ok = modulators[t] != NULL;
+    }
+
+    if (ok) {
+        SpectrumSource source = { modulators, channel, resampler };
+        ok = welch_psd(welch, spectrum_source, &source, start, count, psd, threads, workspaces);
+    }
+
+    for (int t = 0; modulators != NULL && t < tasks; ++t) modulator_destroy(modulators[t]);
+    free(modulators);
+    return ok;
+}
+
+// Renders the whole message using every CPU
+void modulator_render(const ModulatorParams* params, const SymbolTable* symbols, double* out) {
+    int total_samples = (int)modulator_total_samples(params, symbols);
+    if (!modulator_render_range(params, symbols, NULL, 0, out, total_samples, 0, NULL)) {
+        for (int i = 0; i < total_samples; i++) out[i] = 0.0;
+    }
+}
+
+// Slices measured by modulator_signal_power, and their length
+#define POWER_SLICES 16
+#define POWER_SLICE_SAMPLES 16384
+
+double modulator_signal_power(const ModulatorParams* params, const SymbolTable* symbols) {
+    int64_t total_samples = modulator_total_samples(params, symbols);
+    if (total_samples <= 0) return 0.0;
+
+    int slices = POWER_SLICES;
+    int64_t slice_samples = POWER_SLICE_SAMPLES;
+    if (total_samples <= (int64_t)POWER_SLICES * POWER_SLICE_SAMPLES) {
+        slices = 1;
+        slice_samples = total_samples;
+    }
+
+    double* buffer = (double*)malloc(slice_samples * sizeof(double));
+    if (buffer == NULL) return 0.0;
+
+    double sum = 0.0;
+    for (int s = 0; s < slices; ++s) {
+        int64_t start = (total_samples - slice_samples) / (slices > 1 ? slices - 1 : 1) * s;
+        if (!modulator_render_range(params, symbols, NULL, start, buffer, (int)slice_samples, 0, NULL)) break;
+        for (int64_t i = 0; i < slice_samples; ++i) sum += buffer[i] * buffer[i];
+    }
+    free(buffer);
+    return sum / ((double)slices * slice_samples);
+}
+
+void waveform_set_symbols(Waveform* wf, const SymbolTable* symbols) {
+    wf->symbols = symbols;
+    wf->dirty = true;
+}
+
+// Restarts the stream behind the cache only if the symbols or the
+// parameters changed; the samples themselves are rendered on demand. A
+// channel change alone keeps the modulator and its measured power.
+void waveform_update(Waveform* wf, const ModulatorParams* params, const ChannelParams* channel) {
+    bool modulator_changed = wf->dirty || !params_equal(&wf->params, params);
+    if (!modulator_changed && wf->channel != NULL && channel_params_equal(&wf->channel_params, channel)) return;
+
+    double signal_power = wf->channel != NULL ? channel_signal_power(wf->channel) : 0.0;
+    channel_destroy(wf->channel);
+    wf->channel = NULL;
+    wf->length = 0;
+
+    if (modulator_changed) {
+        modulator_destroy(wf->modulator);
+        wf->modulator = NULL;
+        wf->params = *params;
+        wf->total_samples = modulator_total_samples(params, wf->symbols);
+        if (wf->total_samples > 0) {
+            wf->modulator = modulator_create(params, wf->symbols, true);
+            if (wf->modulator == NULL) {
+                wf->total_samples = 0;
+                return; // Keep dirty so the next frame retries
+            }
+        }
+        signal_power = modulator_signal_power(params, wf->symbols);
+        wf->dirty = false;
+    }
+
+    wf->channel_params = *channel;
+    wf->channel = channel_create(channel, params->sampling_rate, params->frequency, params->samples_per_symbol, signal_power);
+    wf->generation++;
+}
+
+// Returns samples [start, start + count) of the looping message, or NULL if
+// there is nothing to show. Views scroll a little per frame, so the cache
+// reads ahead and most frames are served without rendering at all; when
+// it does render, the channel's scratch comes from 'workspace'.
+const double* waveform_window(Waveform* wf, int64_t start, int count, Workspace* workspace) {
+    if (wf->modulator == NULL || count <= 0) return NULL;
+
+    start %= wf->total_samples;
+    if (start < 0) start += wf->total_samples;
+    if (wf->length > 0 && start >= wf->start && start + count <= wf->start + wf->length) {
+        return wf->samples + (start - wf->start);
+    }
+
+    int length = count + count / 2 + WAVEFORM_READAHEAD;
+    if (length > wf->capacity) {
+        double* grown = (double*)realloc(wf->samples, length * sizeof(double));
+        if (grown == NULL) return NULL;
+        wf->samples = grown;
+        wf->capacity = length;
+    }
+
+    if (wf->channel == NULL || channel_is_clean(wf->channel)) {
+        modulator_seek(wf->modulator, start);
+        modulator_next(wf->modulator, wf->samples, length);
+    } else {
+        // The channel's margins come from the loop too, wrapping around
+        // its start
+        int history = channel_history(wf->channel);
+        int input_length = history + length + channel_lookahead(wf->channel);
+        if (input_length > wf->input_capacity) {
+            double* grown = (double*)realloc(wf->input, input_length * sizeof(double));
+            if (grown == NULL) return NULL;
+            wf->input = grown;
+            wf->input_capacity = input_length;
+        }
+        int64_t input_start = (start - history) % wf->total_samples;
+        if (input_start < 0) input_start += wf->total_samples;
+        modulator_seek(wf->modulator, input_start);
+        modulator_next(wf->modulator, wf->input, input_length);
+        if (!channel_process(wf->channel, start, wf->input + history, wf->samples, length, workspace)) return NULL;
+    }
+    wf->start = start;
+    wf->length = length;
+    return wf->samples;
+}
+
+void waveform_free(Waveform* wf) {
+    modulator_destroy(wf->modulator);
+    wf->modulator = NULL;
+    channel_destroy(wf->channel);
+    wf->channel = NULL;
+    free(wf->samples);
+    wf->samples = NULL;
+    free(wf->input);
+    wf->input = NULL;
+    wf->length = 0;
+    wf->capacity = 0;
+    wf->input_capacity = 0;
+}
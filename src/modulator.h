@@ -0,0 +1,121 @@
+#ifndef MODULATOR_H
+#define MODULATOR_H
+
+#include "dsp_common.h"
+#include "symbols.h"
+#include "nco.h"
+#include "pulse_shaper.h"
+#include "channel.h"
+#include "resampler.h"
+#include "welch.h"
+
+// Arithmetic the modulator renders in. Single precision halves the memory
+// traffic and doubles the SIMD width; the carrier phase stays an exact
+// 32-bit integer either way, so the error doesn't grow with signal length.
+// Measured against the double path (error relative to the amplitude, the
+// same for every NCO precision and message length):
+//   FSK                    peak ~1e-7, rms ~2e-8
+//   ASK / PSK / QAM / APSK peak ~5e-7, rms ~6e-8 (the shaper's tap sums)
+// i.e. about -126 dB peak, well below the -106 dB of the interpolated NCO.
+// tests/test_precision.c holds every scheme to these figures.
+typedef enum { SAMPLE_PRECISION_DOUBLE, SAMPLE_PRECISION_SINGLE } SamplePrecision;
+
+// Everything that determines the rendered waveform. The cache below is
+// re-rendered whenever any of these differ from the last render.
+typedef struct {
+    ModulationType mod_type;
+    int bits_per_symbol;
+    int samples_per_symbol;
+    double amplitude;
+    double frequency;
+    double sampling_rate;
+    double rolloff;
+    PulseShape pulse_shape;
+    int pulse_span;
+    double gaussian_bt;
+    NcoPrecision carrier_precision;
+    SamplePrecision sample_precision;
+} ModulatorParams;
+
+// Pull-style streaming modulator. Phase, pulse-shaper history and symbol
+// position carry over between next() calls, so a signal of any length can
+// be produced in chunks with constant memory. With 'loop' the message
+// repeats forever; otherwise next() stops at its last sample.
+typedef struct Modulator Modulator;
+
+Modulator* modulator_create(const ModulatorParams* params, const SymbolTable* symbols, bool loop);
+int modulator_next(Modulator* mod, double* buf, int n);
+// Same, in float. Either call works with either sample precision; samples
+// are only converted when the two differ.
+int modulator_next_f32(Modulator* mod, float* buf, int n);
+void modulator_seek(Modulator* mod, int64_t sample);
+int64_t modulator_tell(const Modulator* mod);
+void modulator_destroy(Modulator* mod);
+
+// Samples rendered past the requested window, so scrolling views don't
+// re-render every frame
+#define WAVEFORM_READAHEAD 8192
+
+// The active message as seen by the views: a looping modulator, the
+// channel after it, and a window of their output. Only what is on screen
+// is ever rendered, so it works the same for a typed message and a
+// multi-gigabyte payload.
+typedef struct {
+    Modulator* modulator;
+    double* samples;  // samples [start, start + length) of the loop
+    int64_t start;
+    int length;
+    int capacity;
+    int64_t total_samples; // one pass of the message
+    ModulatorParams params;
+    ChannelParams channel_params;
+    Channel* channel;
+    double* input;    // modulator output the channel reads, with its margins
+    int input_capacity;
+    const SymbolTable* symbols;
+    bool dirty;
+    int64_t generation; // bumped whenever the signal changes
+} Waveform;
+
+// Renders every sample of the symbols into 'out', which must hold
+// modulator_total_samples() values.
+int64_t modulator_total_samples(const ModulatorParams* params, const SymbolTable* symbols);
+void modulator_render(const ModulatorParams* params, const SymbolTable* symbols, double* out);
+
+// Renders a range of the message across 'threads' workers (0 means one per
+// CPU), passed through 'channel' unless it is NULL. Each worker seeks its
+// own modulator, so the result is bit-identical to a single-threaded
+// render. The workers' channel and resampler scratch comes from
+// 'workspaces', grown to one per worker and kept by the caller so repeated
+// calls reuse it; NULL allocates it for the call. False if an allocation
+// failed.
+bool modulator_render_range(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                            int64_t start, double* out, int count, int threads, WorkspaceSet* workspaces);
+bool modulator_render_range_f32(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                                int64_t start, float* out, int count, int threads, WorkspaceSet* workspaces);
+// The same at the resampler's output rate; 'start' and 'count' are in
+// output samples (see resampler_output_length for the message's length)
+bool modulator_render_resampled_f32(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                                    const Resampler* resampler, int64_t start, float* out, int count, int threads,
+                                    WorkspaceSet* workspaces);
+
+// Welch PSD of outputs [start, start + count), at the resampler's rate if
+// there is one, with the segments rendered across 'threads' workers and
+// their scratch taken from 'workspaces' like modulator_render_range. False
+// if an allocation failed.
+bool modulator_power_spectrum(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                              const Resampler* resampler, const Welch* welch, int64_t start, int64_t count,
+                              double* psd, int threads, WorkspaceSet* workspaces);
+
+// Mean square of the clean signal, for calibrating the channel. A short
+// message is measured whole; a long one from evenly spaced slices, so the
+// cost is bounded however large the payload. 0 if an allocation failed.
+double modulator_signal_power(const ModulatorParams* params, const SymbolTable* symbols);
+
+// Cache management
+void waveform_set_symbols(Waveform* wf, const SymbolTable* symbols);
+void waveform_update(Waveform* wf, const ModulatorParams* params, const ChannelParams* channel);
+const double* waveform_window(Waveform* wf, int64_t start, int count, Workspace* workspace);
+void waveform_free(Waveform* wf);
+
+#endif // MODULATOR_H
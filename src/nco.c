@@ -0,0 +1,82 @@
+#include "nco.h"
+#include <stdbool.h>
+
+double nco_interp_table[(1 << NCO_INTERP_BITS) + 1];
+double nco_dds_table[1 << NCO_DDS_BITS];
+float nco_interp_table_f32[(1 << NCO_INTERP_BITS) + 1];
+float nco_dds_table_f32[1 << NCO_DDS_BITS];
+
+static bool tables_ready = false;
+
+void nco_init_tables(void) {
+    if (tables_ready) return;
+
+    // One guard entry so interpolation never has to wrap the index
+    int interp_size = 1 << NCO_INTERP_BITS;
+    for (int i = 0; i <= interp_size; ++i) {
+        nco_interp_table[i] = sin(2.0 * M_PI * i / interp_size);
+        nco_interp_table_f32[i] = (float)nco_interp_table[i];
+    }
+
+    // Amplitudes quantised exactly as the FPGA ROM stores them
+    int dds_size = 1 << NCO_DDS_BITS;
+    double full_scale = (double)((1 << (NCO_DDS_AMPLITUDE_BITS - 1)) - 1);
+    for (int i = 0; i < dds_size; ++i) {
+        nco_dds_table[i] = round(sin(2.0 * M_PI * i / dds_size) * full_scale) / full_scale;
+        nco_dds_table_f32[i] = (float)nco_dds_table[i];
+    }
+
+    tables_ready = true;
+}
+
+uint32_t nco_increment(double frequency, double sampling_rate) {
+    double cycles_per_sample = fmod(frequency / sampling_rate, 1.0);
+    if (cycles_per_sample < 0.0) cycles_per_sample += 1.0;
+    return (uint32_t)((uint64_t)llround(cycles_per_sample * 4294967296.0) & 0xFFFFFFFFu);
+}
+
+// One loop per precision so the lookup is resolved outside the loop
+#define NCO_FILL_LOOP(PRECISION)                                           \
+    for (int i = 0; i < n; ++i) {                                          \
+        sin_out[i] = nco_sin(p, PRECISION);                                \
+        if (cos_out) cos_out[i] = nco_cos(p, PRECISION);                   \
+        p += increment;                                                    \
+    }
+
+#define NCO_FILL_LOOP_F32(PRECISION)                                       \
+    for (int i = 0; i < n; ++i) {                                          \
+        sin_out[i] = nco_sin_f32(p, PRECISION);                            \
+        if (cos_out) cos_out[i] = nco_cos_f32(p, PRECISION);               \
+        p += increment;                                                    \
+    }
+
+void nco_fill(uint32_t* phase, uint32_t increment, NcoPrecision precision, double* sin_out, double* cos_out, int n) {
+    uint32_t p = *phase;
+    switch (precision) {
+        case NCO_PRECISION_INTERP_LUT: NCO_FILL_LOOP(NCO_PRECISION_INTERP_LUT); break;
+        case NCO_PRECISION_DDS_LUT: NCO_FILL_LOOP(NCO_PRECISION_DDS_LUT); break;
+        case NCO_PRECISION_LIBM:
+        default: NCO_FILL_LOOP(NCO_PRECISION_LIBM); break;
+    }
+    *phase = p;
+}
+
+void nco_fill_f32(uint32_t* phase, uint32_t increment, NcoPrecision precision, float* sin_out, float* cos_out, int n) {
+    uint32_t p = *phase;
+    switch (precision) {
+        case NCO_PRECISION_INTERP_LUT: NCO_FILL_LOOP_F32(NCO_PRECISION_INTERP_LUT); break;
+        case NCO_PRECISION_DDS_LUT: NCO_FILL_LOOP_F32(NCO_PRECISION_DDS_LUT); break;
+        case NCO_PRECISION_LIBM:
+        default: NCO_FILL_LOOP_F32(NCO_PRECISION_LIBM); break;
+    }
+    *phase = p;
+}
+
+const char* nco_precision_name(NcoPrecision precision) {
+    switch (precision) {
+        case NCO_PRECISION_INTERP_LUT: return "LUT";
+        case NCO_PRECISION_DDS_LUT: return "DDS";
+        case NCO_PRECISION_LIBM:
+        default: return "LIBM";
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef NCO_H
+#define NCO_H
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Numerically controlled oscillator. The carrier phase is a 32-bit
+// accumulator (a full turn is 2^32) advanced by a fixed frequency control
+// word per sample, so phase never drifts and wraps for free.
+//
+// How the phase is turned into an amplitude is selectable:
+//   LIBM       - sin() of the accumulator phase; the reference.
+//   INTERP_LUT - 1024-entry table with linear interpolation; worst-case
+//                error ~4.7e-6 of full scale (about -106 dB).
+//   DDS_LUT    - 4096-entry table of 16-bit amplitudes addressed by the top
+//                12 phase bits, the layout of our FPGA DDS, so its output is
+//                bit-exact with the hardware reference.
+typedef enum { NCO_PRECISION_LIBM, NCO_PRECISION_INTERP_LUT, NCO_PRECISION_DDS_LUT } NcoPrecision;
+
+#define NCO_INTERP_BITS 10
+#define NCO_DDS_BITS 12
+#define NCO_DDS_AMPLITUDE_BITS 16
+
+extern double nco_interp_table[(1 << NCO_INTERP_BITS) + 1];
+extern double nco_dds_table[1 << NCO_DDS_BITS];
+// The same tables rounded to float for the single-precision path
+extern float nco_interp_table_f32[(1 << NCO_INTERP_BITS) + 1];
+extern float nco_dds_table_f32[1 << NCO_DDS_BITS];
+
+// Builds the lookup tables; call once before generating anything
+void nco_init_tables(void);
+
+// Frequency control word for 'frequency' Hz at 'sampling_rate' samples/s
+uint32_t nco_increment(double frequency, double sampling_rate);
+const char* nco_precision_name(NcoPrecision precision);
+
+// Writes n consecutive oscillator samples starting at *phase and leaves
+// *phase one increment past the last one. cos_out may be NULL.
+void nco_fill(uint32_t* phase, uint32_t increment, NcoPrecision precision, double* sin_out, double* cos_out, int n);
+// Single-precision version. The phase accumulator is the same integer, so
+// the float rounding error stays constant however long the signal runs.
+void nco_fill_f32(uint32_t* phase, uint32_t increment, NcoPrecision precision, float* sin_out, float* cos_out, int n);
+
+static inline double nco_sin(uint32_t phase, NcoPrecision precision) {
+    switch (precision) {
+        case NCO_PRECISION_INTERP_LUT: {
+            uint32_t index = phase >> (32 - NCO_INTERP_BITS);
+            double frac = (double)(phase & ((1u << (32 - NCO_INTERP_BITS)) - 1)) * (1.0 / (1u << (32 - NCO_INTERP_BITS)));
+            double a = nco_interp_table[index];
+            return a + (nco_interp_table[index + 1] - a) * frac;
+        }
+        case NCO_PRECISION_DDS_LUT:
+            return nco_dds_table[phase >> (32 - NCO_DDS_BITS)];
+        case NCO_PRECISION_LIBM:
+        default:
+            return sin((double)phase * (2.0 * M_PI / 4294967296.0));
+    }
+}
+
+static inline double nco_cos(uint32_t phase, NcoPrecision precision) {
+    return nco_sin(phase + 0x40000000u, precision);
+}
+
+static inline float nco_sin_f32(uint32_t phase, NcoPrecision precision) {
+    switch (precision) {
+        case NCO_PRECISION_INTERP_LUT: {
+            uint32_t index = phase >> (32 - NCO_INTERP_BITS);
+            float frac = (float)(phase & ((1u << (32 - NCO_INTERP_BITS)) - 1)) * (1.0f / (1u << (32 - NCO_INTERP_BITS)));
+            float a = nco_interp_table_f32[index];
+            return a + (nco_interp_table_f32[index + 1] - a) * frac;
+        }
+        case NCO_PRECISION_DDS_LUT:
+            return nco_dds_table_f32[phase >> (32 - NCO_DDS_BITS)];
+        case NCO_PRECISION_LIBM:
+        default:
+            // The reference stays in double; only the result is rounded
+            return (float)sin((double)phase * (2.0 * M_PI / 4294967296.0));
+    }
+}
+
+static inline float nco_cos_f32(uint32_t phase, NcoPrecision precision) {
+    return nco_sin_f32(phase + 0x40000000u, precision);
+}
+
+#endif // NCO_H
@@ -0,0 +1,314 @@
+#include "noise.h"
+#include <math.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) && !defined(__EMSCRIPTEN__) && (defined(__GNUC__) || defined(__clang__))
+#define NOISE_X86 1
+#include <immintrin.h>
+#endif
+
+#define ZIGGURAT_LAYERS 128
+// Start of the tail and area of each layer, for 128 layers
+#define ZIGGURAT_R 3.442619855899
+#define ZIGGURAT_V 9.91256303526217e-3
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// Pairs generated per batch in the block fills; at most 64 so a batch's
+// ziggurat misses fit in one bit mask per half
+#define NOISE_BATCH_PAIRS 64
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): ten rounds of two 32x32->64 multiplies scramble a 128-bit counter
+// under a 64-bit key
+static inline void philox(const uint32_t counter[4], uint64_t seed, uint32_t out[4]) {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+static inline void pair_counter(uint32_t counter[4], NoiseStream stream, uint64_t pair) {
+    counter[0] = (uint32_t)pair;
+    counter[1] = (uint32_t)(pair >> 32);
+    counter[2] = 0;
+    counter[3] = (uint32_t)stream;
+}
+
+typedef void (*PhiloxBatch)(uint64_t first_pair, NoiseStream stream, uint64_t seed, int count,
+                            uint32_t* w0, uint32_t* w1, uint32_t* w2, uint32_t* w3);
+
+// philox() over 'count' consecutive pairs of a stream, written out a word
+// per array
+static void philox_batch_scalar(uint64_t first_pair, NoiseStream stream, uint64_t seed, int count,
+                                uint32_t* w0, uint32_t* w1, uint32_t* w2, uint32_t* w3) {
+    for (int j = 0; j < count; ++j) {
+        uint32_t counter[4], out[4];
+        pair_counter(counter, stream, first_pair + (uint64_t)j);
+        philox(counter, seed, out);
+        w0[j] = out[0]; w1[j] = out[1]; w2[j] = out[2]; w3[j] = out[3];
+    }
+}
+
+#ifdef NOISE_X86
+// The lanes are independent, so the SIMD versions run one pair per 32-bit
+// lane. The multiplies only exist as 32x32->64 on the even lanes, hence
+// the second multiply on the odd lanes shifted down, and the shuffling of
+// the halves back into place.
+#define PHILOX_SIMD_ROUNDS(V, MUL, SRLI64, SLLI64, AND, OR, XOR, SET1)      \
+    for (int r = 0; r < PHILOX_ROUNDS; ++r) {                              \
+        V p0_even = MUL(c0, m0);                                           \
+        V p0_odd = MUL(SRLI64(c0, 32), m0);                                \
+        V p1_even = MUL(c2, m1);                                           \
+        V p1_odd = MUL(SRLI64(c2, 32), m1);                                \
+        V hi0 = OR(SRLI64(p0_even, 32), AND(p0_odd, high));                \
+        V lo0 = OR(AND(p0_even, low), SLLI64(p0_odd, 32));                 \
+        V hi1 = OR(SRLI64(p1_even, 32), AND(p1_odd, high));                \
+        V lo1 = OR(AND(p1_even, low), SLLI64(p1_odd, 32));                 \
+        c0 = XOR(XOR(hi1, c1), SET1((int)k0));                             \
+        c1 = lo1;                                                          \
+        c2 = XOR(XOR(hi0, c3), SET1((int)k1));                             \
+        c3 = lo0;                                                          \
+        k0 += PHILOX_W0;                                                   \
+        k1 += PHILOX_W1;                                                   \
+    }
+
+__attribute__((target("sse2")))
+static void philox_batch_sse2(uint64_t first_pair, NoiseStream stream, uint64_t seed, int count,
+                              uint32_t* w0, uint32_t* w1, uint32_t* w2, uint32_t* w3) {
+    const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+    const __m128i low = _mm_set1_epi64x(0xFFFFFFFF);
+    const __m128i high = _mm_set1_epi64x((long long)0xFFFFFFFF00000000ull);
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    int j = 0;
+    for (; j + 4 <= count; j += 4) {
+        uint64_t pair = first_pair + (uint64_t)j;
+        __m128i base = _mm_set1_epi32((int)(uint32_t)pair);
+        __m128i c0 = _mm_add_epi32(base, _mm_setr_epi32(0, 1, 2, 3));
+        // A lane whose low word wrapped carries into the high word
+        __m128i carry = _mm_cmplt_epi32(_mm_xor_si128(c0, sign), _mm_xor_si128(base, sign));
+        __m128i c1 = _mm_sub_epi32(_mm_set1_epi32((int)(uint32_t)(pair >> 32)), carry);
+        __m128i c2 = _mm_setzero_si128();
+        __m128i c3 = _mm_set1_epi32((int)stream);
+        uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+        PHILOX_SIMD_ROUNDS(__m128i, _mm_mul_epu32, _mm_srli_epi64, _mm_slli_epi64,
+                           _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_set1_epi32)
+        _mm_storeu_si128((__m128i*)(w0 + j), c0);
+        _mm_storeu_si128((__m128i*)(w1 + j), c1);
+        _mm_storeu_si128((__m128i*)(w2 + j), c2);
+        _mm_storeu_si128((__m128i*)(w3 + j), c3);
+    }
+    philox_batch_scalar(first_pair + (uint64_t)j, stream, seed, count - j, w0 + j, w1 + j, w2 + j, w3 + j);
+}
+
+__attribute__((target("avx2")))
+static void philox_batch_avx2(uint64_t first_pair, NoiseStream stream, uint64_t seed, int count,
+                              uint32_t* w0, uint32_t* w1, uint32_t* w2, uint32_t* w3) {
+    const __m256i m0 = _mm256_set1_epi32((int)PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int)PHILOX_M1);
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i high = _mm256_set1_epi64x((long long)0xFFFFFFFF00000000ull);
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        uint64_t pair = first_pair + (uint64_t)j;
+        __m256i base = _mm256_set1_epi32((int)(uint32_t)pair);
+        __m256i c0 = _mm256_add_epi32(base, _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i carry = _mm256_cmpgt_epi32(_mm256_xor_si256(base, sign), _mm256_xor_si256(c0, sign));
+        __m256i c1 = _mm256_sub_epi32(_mm256_set1_epi32((int)(uint32_t)(pair >> 32)), carry);
+        __m256i c2 = _mm256_setzero_si256();
+        __m256i c3 = _mm256_set1_epi32((int)stream);
+        uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+        PHILOX_SIMD_ROUNDS(__m256i, _mm256_mul_epu32, _mm256_srli_epi64, _mm256_slli_epi64,
+                           _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_set1_epi32)
+        _mm256_storeu_si256((__m256i*)(w0 + j), c0);
+        _mm256_storeu_si256((__m256i*)(w1 + j), c1);
+        _mm256_storeu_si256((__m256i*)(w2 + j), c2);
+        _mm256_storeu_si256((__m256i*)(w3 + j), c3);
+    }
+    philox_batch_sse2(first_pair + (uint64_t)j, stream, seed, count - j, w0 + j, w1 + j, w2 + j, w3 + j);
+}
+#endif
+
+static PhiloxBatch philox_batch = philox_batch_scalar;
+
+// Marsaglia & Tsang's tables: a 32-bit signed draw falls inside layer i's
+// rectangle when |draw| < layer_k[i], and maps to x = draw * layer_w[i]
+static uint32_t layer_k[ZIGGURAT_LAYERS];
+static double layer_w[ZIGGURAT_LAYERS];
+static double layer_f[ZIGGURAT_LAYERS];
+static bool tables_ready = false;
+
+void noise_init_tables(void) {
+    if (tables_ready) return;
+
+    const double m1 = 2147483648.0;
+    double dn = ZIGGURAT_R;
+    double tn = dn;
+    double q = ZIGGURAT_V / exp(-0.5 * dn * dn);
+
+    layer_k[0] = (uint32_t)((dn / q) * m1);
+    layer_k[1] = 0;
+    layer_w[0] = q / m1;
+    layer_w[ZIGGURAT_LAYERS - 1] = dn / m1;
+    layer_f[0] = 1.0;
+    layer_f[ZIGGURAT_LAYERS - 1] = exp(-0.5 * dn * dn);
+    for (int i = ZIGGURAT_LAYERS - 2; i >= 1; --i) {
+        dn = sqrt(-2.0 * log(ZIGGURAT_V / dn + exp(-0.5 * dn * dn)));
+        layer_k[i + 1] = (uint32_t)((dn / tn) * m1);
+        tn = dn;
+        layer_f[i] = exp(-0.5 * dn * dn);
+        layer_w[i] = dn / m1;
+    }
+
+#ifdef NOISE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) philox_batch = philox_batch_avx2;
+    else philox_batch = philox_batch_sse2;
+#endif
+
+    tables_ready = true;
+}
+
+// One Philox block feeds two samples: the pair index fills the low half of
+// the counter and the stream the top word. Word 2 is zero for those first
+// draws; the rare samples the ziggurat rejects take more bits from blocks
+// where it counts their extra draws, so no two samples ever share bits.
+typedef struct {
+    uint32_t counter[4];
+    uint64_t seed;
+    uint32_t half;
+    uint32_t draws;
+} ExtraBits;
+
+static uint64_t extra_bits_next(ExtraBits* bits) {
+    uint32_t out[4];
+    bits->counter[2] = (++bits->draws << 1) | bits->half;
+    philox(bits->counter, bits->seed, out);
+    return ((uint64_t)out[1] << 32) | out[0];
+}
+
+// Uniform in (0, 1), never exactly 0 so it is safe to take the log of
+static double extra_uniform(ExtraBits* bits) {
+    return ((extra_bits_next(bits) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// The slow path, for a draw that missed its layer's rectangle: either the
+// base layer's tail or the wedge between rectangle and curve
+static double ziggurat_fix(ExtraBits* bits, int32_t hz, int iz) {
+    for (;;) {
+        double x = hz * layer_w[iz];
+        if (iz == 0) {
+            double y;
+            do {
+                x = -log(extra_uniform(bits)) / ZIGGURAT_R;
+                y = -log(extra_uniform(bits));
+            } while (y + y < x * x);
+            return (hz > 0) ? ZIGGURAT_R + x : -ZIGGURAT_R - x;
+        }
+        if (layer_f[iz] + extra_uniform(bits) * (layer_f[iz - 1] - layer_f[iz]) < exp(-0.5 * x * x)) return x;
+
+        uint64_t next = extra_bits_next(bits);
+        hz = (int32_t)(next >> 32);
+        iz = (int)(next & (ZIGGURAT_LAYERS - 1));
+        if ((uint32_t)(hz < 0 ? -(int64_t)hz : hz) < layer_k[iz]) return hz * layer_w[iz];
+    }
+}
+
+static double ziggurat_miss(uint64_t seed, NoiseStream stream, uint64_t pair, uint32_t half, int32_t hz, int iz) {
+    ExtraBits bits;
+    pair_counter(bits.counter, stream, pair);
+    bits.seed = seed;
+    bits.half = half;
+    bits.draws = 0;
+    return ziggurat_fix(&bits, hz, iz);
+}
+
+// Shapes the 64 bits of one half of a block. The layer index comes from
+// the low bits and the value from the high ones, so the two are
+// independent (the original 32-bit version reused the same bits for both).
+static inline double ziggurat(uint32_t lo, uint32_t hi, uint64_t seed, NoiseStream stream, uint64_t pair, uint32_t half) {
+    int32_t hz = (int32_t)hi;
+    int iz = (int)(lo & (ZIGGURAT_LAYERS - 1));
+    if ((uint32_t)(hz < 0 ? -(int64_t)hz : hz) < layer_k[iz]) return hz * layer_w[iz];
+    return ziggurat_miss(seed, stream, pair, half, hz, iz);
+}
+
+double noise_at(uint64_t seed, NoiseStream stream, int64_t index) {
+    uint32_t counter[4], block[4];
+    // Pairs are numbered by floor(index / 2), so they run on through 0
+    uint32_t half = (uint32_t)((uint64_t)index & 1);
+    uint64_t pair = (uint64_t)(index >> 1);
+    pair_counter(counter, stream, pair);
+    philox(counter, seed, block);
+    return ziggurat(block[2 * half], block[2 * half + 1], seed, stream, pair, half);
+}
+
+// Standard normal samples for 'pairs' consecutive pairs of a stream. Every
+// sample is shaped as if it hit its rectangle first, which keeps the loop
+// free of branches; the few that missed are redone afterwards.
+static void gaussian_batch(uint64_t seed, NoiseStream stream, uint64_t first_pair, int pairs, double* g) {
+    uint32_t w0[NOISE_BATCH_PAIRS], w1[NOISE_BATCH_PAIRS];
+    uint32_t w2[NOISE_BATCH_PAIRS], w3[NOISE_BATCH_PAIRS];
+    philox_batch(first_pair, stream, seed, pairs, w0, w1, w2, w3);
+
+    // One bit per pair and half for the samples that missed
+    uint64_t missed[2] = {0, 0};
+    for (int j = 0; j < pairs; ++j) {
+        int32_t hz0 = (int32_t)w1[j], hz1 = (int32_t)w3[j];
+        int iz0 = (int)(w0[j] & (ZIGGURAT_LAYERS - 1)), iz1 = (int)(w2[j] & (ZIGGURAT_LAYERS - 1));
+        uint32_t abs0 = hz0 < 0 ? 0u - (uint32_t)hz0 : (uint32_t)hz0;
+        uint32_t abs1 = hz1 < 0 ? 0u - (uint32_t)hz1 : (uint32_t)hz1;
+        g[2 * j] = hz0 * layer_w[iz0];
+        g[2 * j + 1] = hz1 * layer_w[iz1];
+        missed[0] |= (uint64_t)(abs0 >= layer_k[iz0]) << j;
+        missed[1] |= (uint64_t)(abs1 >= layer_k[iz1]) << j;
+    }
+
+    for (uint32_t half = 0; half < 2; ++half) {
+        const uint32_t* lo = half ? w2 : w0;
+        const uint32_t* hi = half ? w3 : w1;
+        for (uint64_t bits = missed[half]; bits != 0; bits &= bits - 1) {
+            int j = __builtin_ctzll(bits);
+            g[2 * j + half] = ziggurat_miss(seed, stream, first_pair + j, half, (int32_t)hi[j], (int)(lo[j] & (ZIGGURAT_LAYERS - 1)));
+        }
+    }
+}
+
+// Fills a batch of pairs at a time; a fill that starts or ends mid-pair
+// drops the unused half
+#define NOISE_ADD_LOOP(SCALE_EXPR)                                          \
+    do {                                                                    \
+        double g[2 * NOISE_BATCH_PAIRS];                                    \
+        int i = 0;                                                          \
+        while (i < n) {                                                     \
+            int64_t index = first + i;                                      \
+            int skip = (int)(index & 1);                                    \
+            int count = n - i < 2 * NOISE_BATCH_PAIRS - skip ? n - i : 2 * NOISE_BATCH_PAIRS - skip; \
+            gaussian_batch(seed, stream, (uint64_t)(index >> 1), (skip + count + 1) / 2, g); \
+            for (int k = 0; k < count; ++k) y[i + k] += SCALE_EXPR;         \
+            i += count;                                                     \
+        }                                                                   \
+    } while (0)
+
+void noise_add(uint64_t seed, NoiseStream stream, int64_t first, double* y, int n, double std_dev) {
+    NOISE_ADD_LOOP(std_dev * g[skip + k]);
+}
+
+void noise_add_f32(uint64_t seed, NoiseStream stream, int64_t first, float* y, int n, float std_dev) {
+    NOISE_ADD_LOOP(std_dev * (float)g[skip + k]);
+}
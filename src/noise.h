@@ -0,0 +1,33 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+// Gaussian noise as a pure function of (seed, stream, sample index). The
+// bits come from the Philox4x32-10 counter-based generator and a 128-layer
+// ziggurat shapes them, so any sample can be regenerated on its own: the
+// screen doesn't flicker between frames, and chunked or multi-threaded
+// exports get exactly the noise a single pass would.
+
+#define NOISE_DEFAULT_SEED 0
+
+// Independent noise sequences that share a seed
+typedef enum {
+    NOISE_STREAM_SIGNAL,
+    // 1 and 2 were the IQ plot's own noise, before it read the channel;
+    // the numbers are kept so a seed still gives the same channel
+    NOISE_STREAM_PHASE = 3,
+    NOISE_STREAM_FADING
+} NoiseStream;
+
+// Builds the ziggurat tables; call once before generating anything
+void noise_init_tables(void);
+
+// Standard normal sample number 'index' of a stream
+double noise_at(uint64_t seed, NoiseStream stream, int64_t index);
+
+// y[i] += std_dev * noise_at(seed, stream, first + i), for a whole block
+void noise_add(uint64_t seed, NoiseStream stream, int64_t first, double* y, int n, double std_dev);
+void noise_add_f32(uint64_t seed, NoiseStream stream, int64_t first, float* y, int n, float std_dev);
+
+#endif // NOISE_H
@@ -0,0 +1,164 @@
+#include "parallel.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __EMSCRIPTEN__
+#define PARALLEL_SERIAL 1
+#else
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#endif
+
+#define PARALLEL_MAX_THREADS 256
+
+int parallel_thread_count(int requested) {
+    if (requested > 0) return requested > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS : requested;
+#if defined(PARALLEL_SERIAL)
+    return 1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return cpus > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS : (int)cpus;
+#endif
+}
+
+typedef struct {
+    ParallelTask task;
+    void* context;
+    int task_count;
+    int stride;
+    int first;
+} Worker;
+
+static void run_share(const Worker* worker) {
+    for (int i = worker->first; i < worker->task_count; i += worker->stride) {
+        worker->task(worker->context, i);
+    }
+}
+
+#ifndef PARALLEL_SERIAL
+// The pool: threads 1 to pool_size wait for a share of the next run.
+// Thread 0 is always the caller.
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static pthread_t pool_handles[PARALLEL_MAX_THREADS];
+static Worker pool_shares[PARALLEL_MAX_THREADS]; // task NULL when idle for a run
+static unsigned long pool_joined[PARALLEL_MAX_THREADS]; // last run handed out before each thread started
+static int pool_size = 0;
+static unsigned long pool_run = 0;   // bumped for every run handed out
+static int pool_pending = 0;         // threads yet to finish the current run
+static bool pool_busy = false;       // a run is in progress
+static bool pool_stopping = false;
+
+static void* pool_main(void* arg) {
+    int index = (int)(intptr_t)arg;
+    pthread_mutex_lock(&pool_lock);
+    unsigned long seen = pool_joined[index];
+    for (;;) {
+        while (!pool_stopping && pool_run == seen) pthread_cond_wait(&pool_wake, &pool_lock);
+        if (pool_stopping) break;
+        seen = pool_run;
+        Worker share = pool_shares[index];
+        pthread_mutex_unlock(&pool_lock);
+
+        if (share.task != NULL) run_share(&share);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--pool_pending == 0) pthread_cond_signal(&pool_done);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+// Starts threads up to 'threads' in all, counting the caller. Called with
+// the lock held and no run in progress; a failed spawn leaves the pool
+// smaller.
+static void pool_grow(int threads) {
+    if (threads > PARALLEL_MAX_THREADS) threads = PARALLEL_MAX_THREADS;
+    while (pool_size + 1 < threads) {
+        int index = pool_size + 1;
+        pool_joined[index] = pool_run;
+        if (pthread_create(&pool_handles[index], NULL, pool_main, (void*)(intptr_t)index) != 0) break;
+        pool_size = index;
+    }
+}
+#endif
+
+void parallel_start(int threads) {
+#ifndef PARALLEL_SERIAL
+    threads = parallel_thread_count(threads);
+    pthread_mutex_lock(&pool_lock);
+    if (!pool_busy) pool_grow(threads);
+    pthread_mutex_unlock(&pool_lock);
+#else
+    (void)threads;
+#endif
+}
+
+void parallel_stop(void) {
+#ifndef PARALLEL_SERIAL
+    pthread_mutex_lock(&pool_lock);
+    pool_stopping = true;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+    for (int t = 1; t <= pool_size; ++t) pthread_join(pool_handles[t], NULL);
+    pool_size = 0;
+    pool_stopping = false;
+#endif
+}
+
+void parallel_run(ParallelTask task, void* context, int task_count, int threads) {
+    if (task_count <= 0) return;
+    threads = parallel_thread_count(threads);
+    if (threads > task_count) threads = task_count;
+
+#ifndef PARALLEL_SERIAL
+    if (threads > 1) {
+        // The pool serves one run at a time; a run started while it is
+        // busy (from another thread, or from inside a task) takes every
+        // share on its own caller instead of waiting
+        pthread_mutex_lock(&pool_lock);
+        if (!pool_busy) {
+            pool_busy = true;
+            pool_grow(threads);
+            for (int t = 1; t <= pool_size; ++t) {
+                pool_shares[t] = t < threads ? (Worker){ task, context, task_count, threads, t } : (Worker){0};
+            }
+            pool_pending = pool_size;
+            pool_run++;
+            pthread_cond_broadcast(&pool_wake);
+            int pooled = pool_size;
+            pthread_mutex_unlock(&pool_lock);
+
+            // Thread 0's share runs on the caller, and so do any beyond
+            // the threads the pool managed to start
+            for (int t = 0; t < threads; ++t) {
+                if (t == 0 || t > pooled) {
+                    Worker share = { task, context, task_count, threads, t };
+                    run_share(&share);
+                }
+            }
+
+            pthread_mutex_lock(&pool_lock);
+            while (pool_pending > 0) pthread_cond_wait(&pool_done, &pool_lock);
+            pool_busy = false;
+            pthread_mutex_unlock(&pool_lock);
+            return;
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+#endif
+
+    Worker serial = { task, context, task_count, 1, 0 };
+    run_share(&serial);
+}
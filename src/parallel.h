@@ -0,0 +1,22 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Minimal fork/join helper over a pool of threads that are started once
+// and then wait for work, so a run every frame costs no thread creation.
+// Task i of task_count runs exactly once; tasks are dealt round-robin to
+// the threads, and the calling thread takes a share too. With the thread
+// count resolved and capped at task_count, task i runs after the earlier
+// tasks of i % threads and never alongside them, so scratch can be kept
+// per thread and indexed that way. Without thread support (the web build)
+// everything runs on the caller.
+typedef void (*ParallelTask)(void* context, int task_index);
+
+// Resolves a requested thread count: 0 or less means one per CPU
+int parallel_thread_count(int requested);
+// Starts the pool with 'threads' in all, counting the caller; a run asking
+// for more grows it. parallel_stop joins the threads at exit.
+void parallel_start(int threads);
+void parallel_stop(void);
+void parallel_run(ParallelTask task, void* context, int task_count, int threads);
+
+#endif // PARALLEL_H
@@ -0,0 +1,133 @@
+#include "payload.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__EMSCRIPTEN__)
+#define PAYLOAD_NO_MMAP 1
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(PAYLOAD_NO_MMAP)
+bool payload_open(Payload* payload, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return false;
+    }
+
+    unsigned char* data = (unsigned char*)malloc(size > 0 ? size : 1);
+    if (data == NULL || fread(data, 1, size, file) != (size_t)size) {
+        free(data);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    payload->data = data;
+    payload->length = size;
+    payload->mapped = false;
+    payload->file_handle = NULL;
+    payload->map_handle = NULL;
+    return true;
+}
+
+void payload_close(Payload* payload) {
+    free((void*)payload->data);
+    payload->data = NULL;
+    payload->length = 0;
+}
+
+#elif defined(_WIN32)
+bool payload_open(Payload* payload, const char* path) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // An empty file can't be mapped, but it is still a valid (empty) payload
+    HANDLE mapping = NULL;
+    const unsigned char* data = NULL;
+    if (size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == NULL) {
+            if (mapping != NULL) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+    }
+
+    payload->data = data;
+    payload->length = size.QuadPart;
+    payload->mapped = data != NULL;
+    payload->file_handle = file;
+    payload->map_handle = mapping;
+    return true;
+}
+
+void payload_close(Payload* payload) {
+    if (payload->mapped) UnmapViewOfFile(payload->data);
+    if (payload->map_handle != NULL) CloseHandle((HANDLE)payload->map_handle);
+    if (payload->file_handle != NULL) CloseHandle((HANDLE)payload->file_handle);
+    payload->data = NULL;
+    payload->length = 0;
+    payload->mapped = false;
+    payload->file_handle = NULL;
+    payload->map_handle = NULL;
+}
+
+#else
+bool payload_open(Payload* payload, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // An empty file can't be mapped, but it is still a valid (empty) payload
+    const unsigned char* data = NULL;
+    if (info.st_size > 0) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        // Symbols are mostly read front to back
+        madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+        data = (const unsigned char*)mapping;
+    }
+    close(fd); // The mapping stays valid without the descriptor
+
+    payload->data = data;
+    payload->length = info.st_size;
+    payload->mapped = data != NULL;
+    payload->file_handle = NULL;
+    payload->map_handle = NULL;
+    return true;
+}
+
+void payload_close(Payload* payload) {
+    if (payload->mapped) munmap((void*)payload->data, (size_t)payload->length);
+    payload->data = NULL;
+    payload->length = 0;
+    payload->mapped = false;
+}
+#endif
@@ -0,0 +1,24 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A payload file mapped read-only into memory, so even multi-gigabyte
+// captures are never copied onto the heap. Pages are brought in by the OS
+// as the modulator walks the symbols. Platforms without mmap (the web
+// build) fall back to reading the file into a buffer.
+typedef struct {
+    const unsigned char* data;
+    int64_t length;
+    bool mapped;
+    void* file_handle; // Windows only
+    void* map_handle;  // Windows only
+} Payload;
+
+// Opens and maps 'path'. Returns false if the file can't be opened or
+// mapped, in which case *payload is left untouched.
+bool payload_open(Payload* payload, const char* path);
+void payload_close(Payload* payload);
+
+#endif // PAYLOAD_H
@@ -0,0 +1,126 @@
+#include "pulse_shaper.h"
+#include "dsp_common.h"
+#include <math.h>
+#include <stdlib.h>
+
+static PulseShaper shaper_cache[PULSE_SHAPER_CACHE_SIZE] = {0};
+static unsigned long use_counter = 0;
+
+// Root raised cosine, u = t / T_s
+static double root_raised_cosine(double u, double beta) {
+    if (fabs(u) < 1e-9) {
+        return 1.0 - beta + 4.0 * beta / M_PI;
+    }
+    if (beta > 1e-9 && fabs(fabs(4.0 * beta * u) - 1.0) < 1e-9) {
+        return beta / sqrt(2.0) * ((1.0 + 2.0 / M_PI) * sin(M_PI / (4.0 * beta)) +
+                                   (1.0 - 2.0 / M_PI) * cos(M_PI / (4.0 * beta)));
+    }
+    double numerator = sin(M_PI * u * (1.0 - beta)) + 4.0 * beta * u * cos(M_PI * u * (1.0 + beta));
+    double denominator = M_PI * u * (1.0 - pow(4.0 * beta * u, 2.0));
+    return numerator / denominator;
+}
+
+// Gaussian with bandwidth-time product bt, u = t / T_s, peak of 1
+static double gaussian_pulse(double u, double bt) {
+    if (bt < 1e-3) bt = 1e-3;
+    double a = sqrt(log(2.0) / 2.0) / bt;
+    double x = M_PI * u / a;
+    return exp(-x * x);
+}
+
+// The pulse at u = t / T_s, truncated to +-span symbols
+static double pulse_value(PulseShape shape, double param, double u, int span) {
+    if (fabs(u) > span) return 0.0;
+    switch (shape) {
+        case PULSE_ROOT_RAISED_COSINE: return root_raised_cosine(u, param);
+        case PULSE_GAUSSIAN: return gaussian_pulse(u, param);
+        case PULSE_RECTANGULAR: return (u >= -0.5 && u < 0.5) ? 1.0 : 0.0;
+        case PULSE_RAISED_COSINE:
+        default: return raised_cosine(u, 1.0, param);
+    }
+}
+
+static bool design_tables(PulseShaper* shaper) {
+    int sps = shaper->samples_per_symbol;
+    int num_taps = 2 * shaper->span + 1;
+    double* taps = (double*)malloc((size_t)num_taps * sps * sizeof(double));
+    if (taps == NULL) return false;
+
+    for (int k = 0; k < num_taps; ++k) {
+        for (int phase = 0; phase < sps; ++phase) {
+            double time_from_center = phase - (k - shaper->span + 0.5) * sps;
+            taps[k * sps + phase] = pulse_value(shaper->shape, shaper->param, time_from_center / sps, shaper->span);
+        }
+    }
+
+    shaper->num_taps = num_taps;
+    shaper->taps = taps;
+    return true;
+}
+
+const PulseShaper* pulse_shaper_get(PulseShape shape, double param, int samples_per_symbol, int span) {
+    if (shape == PULSE_RECTANGULAR) param = 0.0; // Not part of the design
+    if (span < 1) span = 1;
+    if (span > PULSE_SHAPER_MAX_SPAN) span = PULSE_SHAPER_MAX_SPAN;
+
+    PulseShaper* victim = &shaper_cache[0];
+    for (int i = 0; i < PULSE_SHAPER_CACHE_SIZE; ++i) {
+        PulseShaper* entry = &shaper_cache[i];
+        if (entry->taps != NULL &&
+            entry->shape == shape &&
+            entry->param == param &&
+            entry->samples_per_symbol == samples_per_symbol &&
+            entry->span == span) {
+            entry->last_used = ++use_counter;
+            return entry;
+        }
+        // Prefer an empty slot, otherwise the least recently used one
+        if (victim->taps != NULL && (entry->taps == NULL || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+
+    free(victim->taps);
+    victim->taps = NULL;
+    victim->shape = shape;
+    victim->param = param;
+    victim->samples_per_symbol = samples_per_symbol;
+    victim->span = span;
+    if (!design_tables(victim)) return NULL;
+    victim->last_used = ++use_counter;
+    return victim;
+}
+
+void pulse_shaper_free_cache(void) {
+    for (int i = 0; i < PULSE_SHAPER_CACHE_SIZE; ++i) {
+        free(shaper_cache[i].taps);
+        shaper_cache[i].taps = NULL;
+    }
+}
+
+int pulse_shaper_matched_filter(PulseShape shape, double param, int samples_per_symbol, int span, double* out, int max_taps) {
+    int half = span * samples_per_symbol;
+    int num_taps = 2 * half + 1;
+    if (num_taps > max_taps) return 0;
+
+    double energy = 0.0;
+    for (int i = 0; i < num_taps; ++i) {
+        out[i] = pulse_value(shape, param, (double)(i - half) / samples_per_symbol, span);
+        energy += out[i] * out[i];
+    }
+    if (energy > 0.0) {
+        double norm = 1.0 / energy;
+        for (int i = 0; i < num_taps; ++i) out[i] *= norm;
+    }
+    return num_taps;
+}
+
+const char* pulse_shape_name(PulseShape shape) {
+    switch (shape) {
+        case PULSE_ROOT_RAISED_COSINE: return "RRC";
+        case PULSE_GAUSSIAN: return "GAUSS";
+        case PULSE_RECTANGULAR: return "RECT";
+        case PULSE_RAISED_COSINE:
+        default: return "RC";
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PULSE_SHAPER_H
+#define PULSE_SHAPER_H
+
+// Symbols on either side of the current one that contribute to a sample
+#define PULSE_SHAPER_SPAN 4
+#define PULSE_SHAPER_MAX_SPAN 16
+
+// Designs kept around so switching shapes or stepping the roll-off back and
+// forth doesn't redesign every time
+#define PULSE_SHAPER_CACHE_SIZE 8
+
+typedef enum {
+    PULSE_RAISED_COSINE,
+    PULSE_ROOT_RAISED_COSINE,
+    PULSE_GAUSSIAN,
+    PULSE_RECTANGULAR
+} PulseShape;
+
+// A pulse sampled at every output phase within a symbol. The table is
+// stored tap-major: taps[k * samples_per_symbol + phase] is the weight of
+// symbol (current + k - span) for a sample 'phase' samples into the
+// current symbol, so shaping one sample is a short multiply-accumulate.
+// 'param' is the roll-off for (root) raised cosine, BT for Gaussian and
+// unused for rectangular.
+typedef struct {
+    PulseShape shape;
+    double param;
+    int samples_per_symbol;
+    int span;
+    int num_taps;
+    double* taps;
+    unsigned long last_used;
+} PulseShaper;
+
+// Returns the design for these parameters from a small LRU cache, designing
+// it on a miss. The pointer stays valid until PULSE_SHAPER_CACHE_SIZE other
+// designs have been requested, so callers that keep taps should copy them.
+// NULL if the allocation fails.
+const PulseShaper* pulse_shaper_get(PulseShape shape, double param, int samples_per_symbol, int span);
+void pulse_shaper_free_cache(void);
+
+// The pulse as a plain FIR at one tap per sample, 2 * span * sps + 1 taps
+// long and divided by its energy, so a symbol's own pulse comes out of it
+// at unit gain. Because every shape here is symmetric it is also its own
+// matched filter, so a root-raised-cosine transmitter and a receiver built
+// from these taps form a matched RRC pair: a raised cosine, with no ISI at
+// multiples of sps (tests/test_pulse_shaper.c checks how little).
+// Returns the tap count, or 0 if 'max_taps' is too small.
+int pulse_shaper_matched_filter(PulseShape shape, double param, int samples_per_symbol, int span, double* out, int max_taps);
+
+const char* pulse_shape_name(PulseShape shape);
+
+#endif // PULSE_SHAPER_H
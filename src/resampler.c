@@ -0,0 +1,168 @@
+#include "resampler.h"
+#include "dsp_common.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Largest numerator or denominator of the rate ratio; keeps the position
+// arithmetic within 64 bits
+#define RESAMPLER_MAX_TERM 2147483647
+// Cut-off as a fraction of the lower rate, and the Kaiser window's beta
+// for roughly 80 dB of stopband
+#define RESAMPLER_CUTOFF 0.45
+#define RESAMPLER_KAISER_BETA 8.0
+
+struct Resampler {
+    double input_rate;
+    int64_t L; // output samples per M input samples
+    int64_t M;
+    int phases;
+    int half; // taps on either side of the output position
+    int taps;
+    double* bank; // phases + 1 rows of 'taps' weights
+};
+
+// Best fraction L/M for 'x' from its continued fraction, stopping once it
+// is exact to double precision or the terms get too large
+static void rate_fraction(double x, int64_t* num, int64_t* den) {
+    int64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+    double v = x;
+    for (int i = 0; i < 64; ++i) {
+        double a = floor(v);
+        if (a > RESAMPLER_MAX_TERM) break;
+        int64_t h2 = (int64_t)a * h1 + h0;
+        int64_t k2 = (int64_t)a * k1 + k0;
+        if (h2 > RESAMPLER_MAX_TERM || k2 > RESAMPLER_MAX_TERM) break;
+        h0 = h1; h1 = h2;
+        k0 = k1; k1 = k2;
+        if (fabs((double)h1 / (double)k1 - x) <= x * 1e-14 || v - a <= 0.0) break;
+        v = 1.0 / (v - a);
+    }
+    *num = h1;
+    *den = k1;
+}
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 64; ++k) {
+        double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+// The prototype at 't' input samples from the centre, for a cut-off of
+// 'cutoff' cycles per input sample and support of +-'support' samples
+static double kernel(double t, double cutoff, double support) {
+    double r = t / support;
+    if (r <= -1.0 || r >= 1.0) return 0.0;
+    double x = 2.0 * cutoff * t;
+    double sinc = fabs(x) < 1e-12 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+    return 2.0 * cutoff * sinc * bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - r * r)) / bessel_i0(RESAMPLER_KAISER_BETA);
+}
+
+Resampler* resampler_create(double input_rate, double output_rate) {
+    if (!(input_rate > 0.0) || !(output_rate > 0.0)) return NULL;
+    Resampler* resampler = (Resampler*)calloc(1, sizeof(Resampler));
+    if (resampler == NULL) return NULL;
+
+    resampler->input_rate = input_rate;
+    rate_fraction(output_rate / input_rate, &resampler->L, &resampler->M);
+    if (resampler->L < 1 || resampler->M < 1) {
+        free(resampler);
+        return NULL;
+    }
+
+    // Decimating narrows the filter to the output rate and widens it in
+    // input samples by the same factor
+    double scale = resampler->L < resampler->M ? (double)resampler->L / (double)resampler->M : 1.0;
+    double cutoff = RESAMPLER_CUTOFF * scale;
+    double support = RESAMPLER_HALF_TAPS / scale;
+    resampler->half = (int)ceil(support);
+    resampler->taps = 2 * resampler->half;
+    resampler->phases = resampler->L <= RESAMPLER_MAX_PHASES ? (int)resampler->L : RESAMPLER_MAX_PHASES;
+
+    resampler->bank = (double*)malloc((size_t)(resampler->phases + 1) * resampler->taps * sizeof(double));
+    if (resampler->bank == NULL) {
+        free(resampler);
+        return NULL;
+    }
+
+    // Row j is for an output j / phases of the way from one input sample
+    // to the next; tap t reads input (index - half + 1 + t). Each row is
+    // normalised to unit gain at DC, so the gain doesn't ripple with the
+    // phase.
+    for (int j = 0; j <= resampler->phases; ++j) {
+        double* row = resampler->bank + (size_t)j * resampler->taps;
+        double fraction = (double)j / resampler->phases;
+        double sum = 0.0;
+        for (int t = 0; t < resampler->taps; ++t) {
+            row[t] = kernel(fraction + resampler->half - 1 - t, cutoff, support);
+            sum += row[t];
+        }
+        for (int t = 0; t < resampler->taps; ++t) row[t] /= sum;
+    }
+    return resampler;
+}
+
+void resampler_destroy(Resampler* resampler) {
+    if (resampler == NULL) return;
+    free(resampler->bank);
+    free(resampler);
+}
+
+double resampler_output_rate(const Resampler* resampler) {
+    return resampler->input_rate * (double)resampler->L / (double)resampler->M;
+}
+
+int64_t resampler_output_length(const Resampler* resampler, int64_t input_samples) {
+    if (input_samples <= 0) return 0;
+    // ceil(input_samples * L / M) without overflowing
+    int64_t whole = input_samples / resampler->M;
+    int64_t rest = input_samples % resampler->M;
+    return whole * resampler->L + (rest * resampler->L + resampler->M - 1) / resampler->M;
+}
+
+// Output m sits at input position index + remainder / L
+static void output_position(const Resampler* resampler, int64_t m, int64_t* index, int64_t* remainder) {
+    int64_t q = m / resampler->L;
+    int64_t r = m % resampler->L;
+    if (r < 0) {
+        r += resampler->L;
+        q--;
+    }
+    int64_t scaled = r * resampler->M;
+    *index = q * resampler->M + scaled / resampler->L;
+    *remainder = scaled % resampler->L;
+}
+
+void resampler_input_span(const Resampler* resampler, int64_t first, int n, int64_t* input_first, int* input_count) {
+    int64_t begin, end, remainder;
+    output_position(resampler, first, &begin, &remainder);
+    output_position(resampler, first + (n > 0 ? n - 1 : 0), &end, &remainder);
+    *input_first = begin - resampler->half + 1;
+    *input_count = (int)(end - begin) + resampler->taps;
+}
+
+void resampler_process(const Resampler* resampler, int64_t first, const double* in, int64_t input_first, double* out, int n) {
+    const int taps = resampler->taps;
+    for (int i = 0; i < n; ++i) {
+        int64_t index, remainder;
+        output_position(resampler, first + i, &index, &remainder);
+        const double* x = in + (index - resampler->half + 1 - input_first);
+
+        // Phase within the bank; with L phases it is always a whole row
+        int64_t scaled = remainder * resampler->phases;
+        const double* row = resampler->bank + (size_t)(scaled / resampler->L) * taps;
+        double acc = 0.0;
+        if (scaled % resampler->L == 0) {
+            for (int t = 0; t < taps; ++t) acc += row[t] * x[t];
+        } else {
+            double fraction = (double)(scaled % resampler->L) / (double)resampler->L;
+            const double* next = row + taps;
+            for (int t = 0; t < taps; ++t) acc += (row[t] + fraction * (next[t] - row[t])) * x[t];
+        }
+        out[i] = acc;
+    }
+}
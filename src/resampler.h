@@ -0,0 +1,40 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+// Polyphase fractional resampler from one sampling rate to another. The
+// ratio is kept as an exact fraction L/M, so output sample m sits exactly
+// at input position m * M / L and the output rate doesn't drift however
+// long the signal runs. Each output is a pure function of its index, so a
+// range can be resampled in pieces or across threads and come out the same.
+//
+// The filter is a Kaiser-windowed sinc, cut off at 0.45 of the lower of
+// the two rates so nothing aliases when decimating. Small L get one exact
+// phase per output position; larger L interpolate between
+// RESAMPLER_MAX_PHASES phases.
+
+// Zero crossings of the sinc on either side of its centre
+#define RESAMPLER_HALF_TAPS 32
+#define RESAMPLER_MAX_PHASES 1024
+
+typedef struct Resampler Resampler;
+
+// NULL if the allocation fails or either rate isn't positive
+Resampler* resampler_create(double input_rate, double output_rate);
+void resampler_destroy(Resampler* resampler);
+
+// The exact rate the output comes out at, input_rate * L / M
+double resampler_output_rate(const Resampler* resampler);
+
+// Output samples covering 'input_samples' of input
+int64_t resampler_output_length(const Resampler* resampler, int64_t input_samples);
+
+// The input samples that outputs [first, first + n) read
+void resampler_input_span(const Resampler* resampler, int64_t first, int n, int64_t* input_first, int* input_count);
+
+// Produces outputs [first, first + n). 'in' holds the span reported by
+// resampler_input_span, starting at input sample 'input_first'.
+void resampler_process(const Resampler* resampler, int64_t first, const double* in, int64_t input_first, double* out, int n);
+
+#endif // RESAMPLER_H
@@ -4,12 +4,15 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <stdbool.h>
+#include "dsp_common.h"
+#include "workspace.h"
 
 // --- Shared Enums ---
 typedef enum { MODE_TYPING, MODE_COMMAND } AppMode;
-typedef enum { MOD_ASK, MOD_FSK, MOD_PSK } ModulationType;
 typedef enum { VIEW_TIME_DOMAIN, VIEW_IQ_PLOT , VIEW_POWER_SPECTRUM } ViewMode;
-typedef enum { WINDOW_HANN, WINDOW_HAMMING, WINDOW_RECTANGULAR } WindowType;
+// One periodogram at the view, Welch's average of segments from the view
+// on, or of segments across the whole message
+typedef enum { SPECTRUM_SINGLE, SPECTRUM_AVERAGE_VIEW, SPECTRUM_AVERAGE_MESSAGE } SpectrumAveraging;
 
 // --- Extern Global Variable Declarations ---
 extern int SCREEN_WIDTH;
@@ -20,7 +23,7 @@ extern int pixelsPerBit;
 extern double snr_db;
 extern double rolloff_factor;
 extern int bitsPerSymbol;
-extern double time_offset;
+extern int64_t sample_clock;
 extern double sampling_rate;
 extern double pixels_per_second;
 extern double spectrum_center_freq;
@@ -28,14 +31,17 @@ extern double spectrum_span;
 extern int fft_size;
 extern WindowType current_window_type;
 extern int spectrum_power;
+extern SpectrumAveraging spectrum_averaging;
+extern double spectrum_overlap;
+extern int spectrum_segments;
 extern double hovered_frequency;
 extern double hovered_power;
 extern int mouse_x;
 extern int mouse_y;
-
-// --- Shared Helper Function Prototypes ---
-int get_symbol_at_index(int symbol_index, const char* message, int message_len, int bits_per_sym);
-double sinc(double x);
-double raised_cosine(double t, double T_s, double beta);
+extern int export_threads;
+extern double export_rate;
+extern uint64_t noise_seed;
+// Scratch for drawing a frame, released at the start of the next one
+extern Workspace frame_workspace;
 
 #endif // SHARED_H
\ No newline at end of file
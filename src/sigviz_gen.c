@@ -0,0 +1,423 @@
+// src/sigviz_gen.c
+//
+// Headless waveform generator: the same modulator as the GUI, driven from
+// the command line and streamed to a file or stdout as raw 32-bit floats
+// (the .32fl format the S key exports).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "dsp_common.h"
+#include "modulator.h"
+#include "mod_kernels.h"
+#include "fft_kernels.h"
+#include "parallel.h"
+#include "payload.h"
+#include "constellation.h"
+#include "noise.h"
+#include "channel.h"
+#include "welch.h"
+
+// Samples each thread renders per round; output memory stays at
+// threads * CHUNK_SAMPLES regardless of payload size
+#define CHUNK_SAMPLES 262144
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options] --payload FILE\n"
+        "\n"
+        "  -m, --mod ask|fsk|psk|qam|apsk  Modulation (default ask)\n"
+        "  -b, --bits N              Bits per symbol (default 1)\n"
+        "      --order M             Modulation order, a power of two (sets --bits)\n"
+        "  -r, --rolloff X           Roll-off factor (default 0.35)\n"
+        "  -n, --snr DB              Signal-to-noise ratio, 100 or more is noiseless (default 100)\n"
+        "      --seed N              Noise seed; the same seed gives the same noise (default %d)\n"
+        "      --multipath NAME      none|two-ray|three-ray|dense (default none)\n"
+        "      --cfo HZ              Carrier frequency offset (default 0)\n"
+        "      --phase-noise DEG     Rms phase noise (default 0)\n"
+        "      --pn-bandwidth HZ     Phase noise bandwidth (default 10)\n"
+        "      --dc X                DC offset on I and Q, relative to the signal rms (default 0)\n"
+        "      --iq-gain DB          IQ gain imbalance (default 0)\n"
+        "      --iq-phase DEG        IQ phase imbalance (default 0)\n"
+        "      --fading NAME         none|rayleigh|rician, over the multipath taps (default none)\n"
+        "      --doppler HZ          Maximum Doppler shift of the fading (default 1)\n"
+        "      --rician-k DB         Line of sight to scattered power (default 6)\n"
+        "  -c, --carrier HZ          Carrier frequency (default 300)\n"
+        "  -s, --rate HZ             Sampling rate (default 4000)\n"
+        "      --out-rate HZ         Resample the output to this rate (default: the sampling rate)\n"
+        "  -p, --sps N               Samples per symbol (default 50)\n"
+        "  -a, --amplitude X         Peak amplitude (default 100)\n"
+        "      --shape rc|rrc|gauss|rect  Pulse shape (default rc)\n"
+        "      --span N              Pulse span in symbols (default %d)\n"
+        "      --bt X                Gaussian bandwidth-time product (default 0.5)\n"
+        "      --nco libm|lut|dds    Carrier NCO precision (default lut)\n"
+        "      --precision double|single  Arithmetic to generate in (default double)\n"
+        "      --kernels NAME        Force scalar|sse2|avx2|avx512|neon kernels (modulator and FFT)\n"
+        "  -t, --threads N           Worker threads, 0 for one per CPU (default 0)\n"
+        "  -i, --payload FILE        Payload to modulate\n"
+        "  -o, --out FILE            Output file, '-' for stdout (default, unless only --psd is asked for)\n"
+        "      --psd FILE            Write the Welch PSD of the output as 'Hz dB/Hz' lines\n"
+        "      --psd-size N          PSD segment length, a power of two (default 4096)\n"
+        "      --psd-overlap X       Fraction of each segment shared with the next, 0-0.95 (default 0.5)\n"
+        "      --psd-segments N      At most N segments, spread evenly; 0 for all (default 0)\n"
+        "      --psd-window hann|hamming|rect  PSD window (default hann)\n"
+        "      --psd-start SEC       Start of the PSD range (default 0)\n"
+        "      --psd-length SEC      Length of the PSD range (default: to the end)\n"
+        "  -h, --help                Show this help\n",
+        program, NOISE_DEFAULT_SEED, PULSE_SHAPER_SPAN);
+}
+
+static bool parse_mod(const char* s, ModulationType* out) {
+    if (strcmp(s, "ask") == 0) { *out = MOD_ASK; return true; }
+    if (strcmp(s, "fsk") == 0) { *out = MOD_FSK; return true; }
+    if (strcmp(s, "psk") == 0) { *out = MOD_PSK; return true; }
+    if (strcmp(s, "qam") == 0) { *out = MOD_QAM; return true; }
+    if (strcmp(s, "apsk") == 0) { *out = MOD_APSK; return true; }
+    return false;
+}
+
+static bool parse_multipath(const char* s, MultipathProfile* out) {
+    for (int p = 0; p < MULTIPATH_PROFILE_COUNT; ++p) {
+        if (strcmp(s, multipath_profile_name((MultipathProfile)p)) == 0) { *out = (MultipathProfile)p; return true; }
+    }
+    return false;
+}
+
+static bool parse_fading(const char* s, FadingModel* out) {
+    for (int m = 0; m < FADING_MODEL_COUNT; ++m) {
+        if (strcmp(s, fading_model_name((FadingModel)m)) == 0) { *out = (FadingModel)m; return true; }
+    }
+    return false;
+}
+
+static bool parse_shape(const char* s, PulseShape* out) {
+    if (strcmp(s, "rc") == 0) { *out = PULSE_RAISED_COSINE; return true; }
+    if (strcmp(s, "rrc") == 0) { *out = PULSE_ROOT_RAISED_COSINE; return true; }
+    if (strcmp(s, "gauss") == 0) { *out = PULSE_GAUSSIAN; return true; }
+    if (strcmp(s, "rect") == 0) { *out = PULSE_RECTANGULAR; return true; }
+    return false;
+}
+
+static bool parse_precision(const char* s, SamplePrecision* out) {
+    if (strcmp(s, "double") == 0) { *out = SAMPLE_PRECISION_DOUBLE; return true; }
+    if (strcmp(s, "single") == 0) { *out = SAMPLE_PRECISION_SINGLE; return true; }
+    return false;
+}
+
+static bool parse_nco(const char* s, NcoPrecision* out) {
+    if (strcmp(s, "libm") == 0) { *out = NCO_PRECISION_LIBM; return true; }
+    if (strcmp(s, "lut") == 0) { *out = NCO_PRECISION_INTERP_LUT; return true; }
+    if (strcmp(s, "dds") == 0) { *out = NCO_PRECISION_DDS_LUT; return true; }
+    return false;
+}
+
+static bool parse_window(const char* s, WindowType* out) {
+    if (strcmp(s, "hann") == 0) { *out = WINDOW_HANN; return true; }
+    if (strcmp(s, "hamming") == 0) { *out = WINDOW_HAMMING; return true; }
+    if (strcmp(s, "rect") == 0) { *out = WINDOW_RECTANGULAR; return true; }
+    return false;
+}
+
+// One line per bin: its frequency and the density in dB
+static bool write_psd(const char* path, const double* psd, int bins, double bin_hz) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return false;
+    for (int k = 0; k < bins; ++k) {
+        fprintf(file, "%.6f %.4f\n", k * bin_hz, 10.0 * log10(psd[k] + 1e-30));
+    }
+    return fclose(file) == 0;
+}
+
+static double seconds_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char* argv[]) {
+    ModulatorParams params;
+    params.mod_type = MOD_ASK;
+    params.bits_per_symbol = 1;
+    params.samples_per_symbol = 50;
+    params.amplitude = 100.0;
+    params.frequency = 300.0;
+    params.sampling_rate = 4000.0;
+    params.rolloff = 0.35;
+    params.pulse_shape = PULSE_RAISED_COSINE;
+    params.pulse_span = PULSE_SHAPER_SPAN;
+    params.gaussian_bt = 0.5;
+    params.carrier_precision = NCO_PRECISION_INTERP_LUT;
+    params.sample_precision = SAMPLE_PRECISION_DOUBLE;
+
+    ChannelParams channel_params;
+    channel_params.snr_db = CHANNEL_SNR_NOISELESS;
+    channel_params.noise_seed = NOISE_DEFAULT_SEED;
+    channel_params.multipath = MULTIPATH_NONE;
+    channel_params.cfo_hz = 0.0;
+    channel_params.phase_noise_deg = 0.0;
+    channel_params.phase_noise_bandwidth = 10.0;
+    channel_params.dc_offset = 0.0;
+    channel_params.iq_gain_db = 0.0;
+    channel_params.iq_phase_deg = 0.0;
+    channel_params.fading = FADING_NONE;
+    channel_params.doppler_hz = 1.0;
+    channel_params.rician_k_db = 6.0;
+    const char* payload_path = NULL;
+    const char* out_path = NULL;
+    const char* kernels_name = NULL;
+    int threads = 0;
+    double out_rate = 0.0;
+
+    WelchParams welch_params;
+    welch_params.segment_size = 4096;
+    welch_params.overlap = 0.5;
+    welch_params.max_segments = 0;
+    welch_params.window = WINDOW_HANN;
+    welch_params.sample_rate = 0.0; // the output rate, once known
+    const char* psd_path = NULL;
+    double psd_start = 0.0;
+    double psd_length = 0.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+        bool ok = true;
+
+        if (strcmp(arg, "-m") == 0 || strcmp(arg, "--mod") == 0) ok = parse_mod(value, &params.mod_type);
+        else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--bits") == 0) params.bits_per_symbol = atoi(value);
+        else if (strcmp(arg, "--order") == 0) {
+            int order = atoi(value);
+            int bits = 0;
+            while ((1 << bits) < order) bits++;
+            ok = order >= 2 && (1 << bits) == order;
+            params.bits_per_symbol = bits;
+        }
+        else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--rolloff") == 0) params.rolloff = atof(value);
+        else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--snr") == 0) channel_params.snr_db = atof(value);
+        else if (strcmp(arg, "--seed") == 0) channel_params.noise_seed = strtoull(value, NULL, 0);
+        else if (strcmp(arg, "--multipath") == 0) ok = parse_multipath(value, &channel_params.multipath);
+        else if (strcmp(arg, "--cfo") == 0) channel_params.cfo_hz = atof(value);
+        else if (strcmp(arg, "--phase-noise") == 0) channel_params.phase_noise_deg = atof(value);
+        else if (strcmp(arg, "--pn-bandwidth") == 0) channel_params.phase_noise_bandwidth = atof(value);
+        else if (strcmp(arg, "--dc") == 0) channel_params.dc_offset = atof(value);
+        else if (strcmp(arg, "--iq-gain") == 0) channel_params.iq_gain_db = atof(value);
+        else if (strcmp(arg, "--iq-phase") == 0) channel_params.iq_phase_deg = atof(value);
+        else if (strcmp(arg, "--fading") == 0) ok = parse_fading(value, &channel_params.fading);
+        else if (strcmp(arg, "--doppler") == 0) channel_params.doppler_hz = atof(value);
+        else if (strcmp(arg, "--rician-k") == 0) channel_params.rician_k_db = atof(value);
+        else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--carrier") == 0) params.frequency = atof(value);
+        else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--rate") == 0) params.sampling_rate = atof(value);
+        else if (strcmp(arg, "--out-rate") == 0) ok = (out_rate = atof(value)) > 0.0;
+        else if (strcmp(arg, "-p") == 0 || strcmp(arg, "--sps") == 0) params.samples_per_symbol = atoi(value);
+        else if (strcmp(arg, "-a") == 0 || strcmp(arg, "--amplitude") == 0) params.amplitude = atof(value);
+        else if (strcmp(arg, "--shape") == 0) ok = parse_shape(value, &params.pulse_shape);
+        else if (strcmp(arg, "--span") == 0) params.pulse_span = atoi(value);
+        else if (strcmp(arg, "--bt") == 0) params.gaussian_bt = atof(value);
+        else if (strcmp(arg, "--nco") == 0) ok = parse_nco(value, &params.carrier_precision);
+        else if (strcmp(arg, "--precision") == 0) ok = parse_precision(value, &params.sample_precision);
+        else if (strcmp(arg, "--kernels") == 0) kernels_name = value;
+        else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) threads = atoi(value);
+        else if (strcmp(arg, "-i") == 0 || strcmp(arg, "--payload") == 0) payload_path = value;
+        else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--out") == 0) out_path = value;
+        else if (strcmp(arg, "--psd") == 0) psd_path = value;
+        else if (strcmp(arg, "--psd-size") == 0) {
+            int size = atoi(value);
+            ok = size >= 2 && (size & (size - 1)) == 0;
+            welch_params.segment_size = size;
+        }
+        else if (strcmp(arg, "--psd-overlap") == 0) ok = (welch_params.overlap = atof(value)) >= 0.0 && welch_params.overlap <= 0.95;
+        else if (strcmp(arg, "--psd-segments") == 0) ok = (welch_params.max_segments = atoi(value)) >= 0;
+        else if (strcmp(arg, "--psd-window") == 0) ok = parse_window(value, &welch_params.window);
+        else if (strcmp(arg, "--psd-start") == 0) ok = (psd_start = atof(value)) >= 0.0;
+        else if (strcmp(arg, "--psd-length") == 0) ok = (psd_length = atof(value)) > 0.0;
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid value for %s: %s\n", arg, value);
+            return 1;
+        }
+    }
+
+    if (payload_path == NULL) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    // Only the PSD if that's all that was asked for
+    if (out_path == NULL && psd_path == NULL) out_path = "-";
+    if (params.bits_per_symbol < 1 || params.bits_per_symbol > 16 ||
+        params.samples_per_symbol < 1 || params.sampling_rate <= 0.0) {
+        fprintf(stderr, "Bits per symbol must be 1-16, samples per symbol and rate positive.\n");
+        return 1;
+    }
+    if (params.mod_type != MOD_FSK && constellation_get(params.mod_type, params.bits_per_symbol) == NULL) {
+        fprintf(stderr, "%s has no constellation of order %d.\n", modulation_name(params.mod_type), 1 << params.bits_per_symbol);
+        return 1;
+    }
+
+    nco_init_tables();
+    noise_init_tables();
+    mod_kernels_init();
+    fft_kernels_init();
+    if (kernels_name != NULL && (!mod_kernels_select(kernels_name) || !fft_kernels_select(kernels_name))) {
+        fprintf(stderr, "Kernels '%s' are not available on this machine.\n", kernels_name);
+        return 1;
+    }
+
+    // The payload is mapped, not read, so its size is only bounded by the
+    // address space
+    Payload payload = {0};
+    if (!payload_open(&payload, payload_path)) {
+        fprintf(stderr, "Failed to read payload '%s'.\n", payload_path);
+        return 1;
+    }
+
+    SymbolTable symbols = {0};
+    if (!symbol_table_build(&symbols, payload.data, payload.length, params.bits_per_symbol)) {
+        fprintf(stderr, "Failed to allocate the symbol table.\n");
+        payload_close(&payload);
+        return 1;
+    }
+
+    FILE* out = NULL;
+    if (out_path == NULL) {
+        // PSD only
+    } else if (strcmp(out_path, "-") == 0) {
+        out = stdout;
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else {
+        out = fopen(out_path, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "Failed to open '%s' for writing.\n", out_path);
+            symbol_table_free(&symbols);
+            payload_close(&payload);
+            return 1;
+        }
+    }
+
+    threads = parallel_thread_count(threads);
+    parallel_start(threads);
+    int round_samples = CHUNK_SAMPLES * threads;
+    float* chunk = out != NULL ? (float*)malloc(round_samples * sizeof(float)) : NULL;
+    int status = 0;
+
+    // Calibrated to the measured power of the clean signal, like the GUI
+    Channel* channel = channel_create(&channel_params, params.sampling_rate, params.frequency, params.samples_per_symbol,
+                                      modulator_signal_power(&params, &symbols));
+
+    // Generated at an integer number of samples per symbol, then resampled
+    bool resampled = out_rate > 0.0 && out_rate != params.sampling_rate;
+    Resampler* resampler = resampled ? resampler_create(params.sampling_rate, out_rate) : NULL;
+
+    int64_t total_samples = modulator_total_samples(&params, &symbols);
+    if (resampler != NULL) total_samples = resampler_output_length(resampler, total_samples);
+    int64_t total_written = 0;
+    // Each thread's channel and resampler scratch, kept across the chunks
+    WorkspaceSet workspaces = {0};
+    double start = seconds_now();
+    if ((out != NULL && chunk == NULL) || channel == NULL || (resampled && resampler == NULL)) {
+        fprintf(stderr, "Failed to allocate the output buffers.\n");
+        status = 1;
+    }
+    while (status == 0 && out != NULL && total_written < total_samples) {
+        int count = total_samples - total_written < round_samples ? (int)(total_samples - total_written) : round_samples;
+        // Rendered straight to float; in single precision nothing is converted
+        bool rendered = resampler != NULL ?
+            modulator_render_resampled_f32(&params, &symbols, channel, resampler, total_written, chunk, count, threads,
+                                           &workspaces) :
+            modulator_render_range_f32(&params, &symbols, channel, total_written, chunk, count, threads, &workspaces);
+        if (!rendered) {
+            fprintf(stderr, "Failed to allocate the modulators.\n");
+            status = 1;
+            break;
+        }
+        if (fwrite(chunk, sizeof(float), count, out) != (size_t)count) {
+            fprintf(stderr, "Write failed.\n");
+            status = 1;
+            break;
+        }
+        total_written += count;
+    }
+    double elapsed = seconds_now() - start;
+
+    if (out != NULL) {
+        if (out != stdout) fclose(out);
+        else fflush(out);
+        fprintf(stderr, "sigviz-gen: %lld samples in %.3f s (%.2f Msps, %s kernels, %d threads)\n",
+                (long long)total_written, elapsed, elapsed > 0.0 ? total_written / elapsed / 1e6 : 0.0, mod_kernels_get()->name, threads);
+    }
+
+    // The PSD is of the same signal, at the output rate, averaged over
+    // the whole of it unless a range was given
+    if (status == 0 && psd_path != NULL) {
+        welch_params.sample_rate = resampler != NULL ? resampler_output_rate(resampler) : params.sampling_rate;
+        int64_t psd_first = (int64_t)llround(psd_start * welch_params.sample_rate);
+        if (psd_first > total_samples) psd_first = total_samples;
+        int64_t psd_count = total_samples - psd_first;
+        if (psd_length > 0.0 && (int64_t)llround(psd_length * welch_params.sample_rate) < psd_count) {
+            psd_count = (int64_t)llround(psd_length * welch_params.sample_rate);
+        }
+
+        Welch* welch = welch_create(&welch_params);
+        double* psd = welch != NULL ? (double*)malloc(welch_bins(welch) * sizeof(double)) : NULL;
+        double psd_started = seconds_now();
+        if (psd_count <= 0) {
+            fprintf(stderr, "The PSD range is empty.\n");
+            status = 1;
+        } else if (psd == NULL || !modulator_power_spectrum(&params, &symbols, channel, resampler, welch,
+                                                            psd_first, psd_count, psd, threads,
+                                                            &workspaces)) {
+            fprintf(stderr, "Failed to allocate the PSD buffers.\n");
+            status = 1;
+        } else if (!write_psd(psd_path, psd, welch_bins(welch), welch_params.sample_rate / welch_params.segment_size)) {
+            fprintf(stderr, "Failed to write '%s'.\n", psd_path);
+            status = 1;
+        } else {
+            double psd_elapsed = seconds_now() - psd_started;
+            fprintf(stderr, "sigviz-gen: PSD of %d segments of %d over %lld samples in %.3f s (%.2f Msps, %s FFT kernels)\n",
+                    welch_segment_count(welch, psd_count), welch_params.segment_size, (long long)psd_count, psd_elapsed,
+                    psd_elapsed > 0.0 ? psd_count / psd_elapsed / 1e6 : 0.0, fft_kernels_get()->name);
+        }
+        free(psd);
+        welch_destroy(welch);
+    }
+    if (channel != NULL && channel_params.fading != FADING_NONE) {
+        FadingStats fading = channel_fading_stats(channel);
+        fprintf(stderr, "sigviz-gen: %s fading over %s taps, %lld gain updates, %.3f s of thread CPU time (%.2f Msps)\n",
+                fading_model_name(channel_params.fading), multipath_profile_name(channel_params.multipath),
+                (long long)fading.gain_updates, fading.seconds, fading.seconds > 0.0 ? fading.samples / fading.seconds / 1e6 : 0.0);
+    }
+
+    free(chunk);
+    workspace_set_free(&workspaces);
+    resampler_destroy(resampler);
+    channel_destroy(channel);
+    symbol_table_free(&symbols);
+    payload_close(&payload);
+    pulse_shaper_free_cache();
+    constellation_free_tables();
+    parallel_stop();
+    return status;
+}
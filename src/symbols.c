@@ -0,0 +1,120 @@
+#include "symbols.h"
+#include "dsp_common.h"
+#include <stdlib.h>
+
+// Matches get_symbol_at_index(): bits past the end of the message are
+// dropped rather than read as zeros
+int symbol_table_value_slow(const SymbolTable* table, int64_t index) {
+    return get_symbol_at_index(index, (const char*)table->message, table->message_len, table->bits_per_symbol);
+}
+
+// Sums 'count' values starting at symbol 'first'
+static uint32_t sum_values(const SymbolTable* table, int64_t first, int64_t count) {
+    uint32_t sum = 0;
+    for (int64_t i = first; i < first + count; ++i) sum += (uint32_t)symbol_table_value(table, i);
+    return sum;
+}
+
+// Symbols line up with byte boundaries again every lcm(bits, 8) bits, a
+// group of 'bits / gcd(bits, 8)' bytes. Each bit of such a group always
+// lands at the same place within its symbol, so a byte's contribution to
+// the sum depends only on its value and its position in the group. That
+// turns summing a block into one table lookup per byte, which keeps
+// building the checkpoints for a gigabyte payload around a second.
+static void build_value_sums(SymbolTable* table) {
+    int bits = table->bits_per_symbol;
+    int gcd = bits;
+    for (int b = 8; b != 0;) { int t = gcd % b; gcd = b; b = t; }
+    int group_bytes = bits / gcd;
+
+    uint32_t byte_sums[16][256];
+    for (int k = 0; k < group_bytes; ++k) {
+        for (int value = 0; value < 256; ++value) {
+            uint32_t sum = 0;
+            for (int i = 0; i < 8; ++i) {
+                int bit_in_symbol = (k * 8 + i) % bits;
+                if ((value >> (7 - i)) & 1) sum += 1u << (bits - 1 - bit_in_symbol);
+            }
+            byte_sums[k][value] = sum;
+        }
+    }
+
+    int64_t blocks = table->count / SYMBOL_SUM_STRIDE;
+    int block_bytes = SYMBOL_SUM_STRIDE * bits / 8; // a whole number of groups
+    const unsigned char* p = table->message;
+    uint32_t sum = 0;
+    table->value_sums[0] = 0;
+    for (int64_t j = 0; j < blocks; ++j) {
+        if (group_bytes == 1) {
+            for (int i = 0; i < block_bytes; ++i) sum += byte_sums[0][p[i]];
+        } else {
+            for (int i = 0, k = 0; i < block_bytes; ++i) {
+                sum += byte_sums[k][p[i]];
+                if (++k == group_bytes) k = 0;
+            }
+        }
+        p += block_bytes;
+        table->value_sums[j + 1] = sum;
+    }
+    table->total_sum = sum + sum_values(table, blocks * SYMBOL_SUM_STRIDE, table->count - blocks * SYMBOL_SUM_STRIDE);
+}
+
+bool symbol_table_build(SymbolTable* table, const unsigned char* message, int64_t message_len, int bits_per_symbol) {
+    table->message = message;
+    table->message_len = message_len;
+    table->bits_per_symbol = bits_per_symbol;
+    table->count = 0;
+    table->total_sum = 0;
+    if (message_len <= 0) return true;
+
+    // A message shorter than one symbol still produces that one symbol
+    int64_t total_symbols = (message_len * 8) / bits_per_symbol;
+    if (total_symbols == 0) total_symbols = 1;
+
+    int64_t checkpoints = total_symbols / SYMBOL_SUM_STRIDE + 1;
+    if (checkpoints > table->sums_capacity) {
+        uint32_t* grown = (uint32_t*)realloc(table->value_sums, checkpoints * sizeof(uint32_t));
+        if (grown == NULL) return false;
+        table->value_sums = grown;
+        table->sums_capacity = checkpoints;
+    }
+
+    if (total_symbols <= SYMBOL_UNPACK_MAX) {
+        uint16_t* values = table->values;
+        if (total_symbols > table->values_capacity) {
+            values = (uint16_t*)realloc(table->values, total_symbols * sizeof(uint16_t));
+            if (values == NULL) return false;
+            table->values_capacity = total_symbols;
+        }
+        table->values = NULL; // so the lookups below read the packed bytes
+        table->count = total_symbols;
+        for (int64_t i = 0; i < total_symbols; ++i) values[i] = (uint16_t)symbol_table_value_packed(table, i);
+        table->values = values;
+    } else {
+        free(table->values);
+        table->values = NULL;
+        table->values_capacity = 0;
+        table->count = total_symbols;
+    }
+
+    build_value_sums(table);
+    return true;
+}
+
+uint32_t symbol_table_value_sum(const SymbolTable* table, int64_t index) {
+    if (index >= table->count) return table->total_sum;
+    int64_t block = index / SYMBOL_SUM_STRIDE;
+    return table->value_sums[block] + sum_values(table, block * SYMBOL_SUM_STRIDE, index - block * SYMBOL_SUM_STRIDE);
+}
+
+void symbol_table_free(SymbolTable* table) {
+    free(table->values);
+    table->values = NULL;
+    table->values_capacity = 0;
+    free(table->value_sums);
+    table->value_sums = NULL;
+    table->sums_capacity = 0;
+    table->message = NULL;
+    table->message_len = 0;
+    table->count = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Every this many symbols the running value sum is stored
+#define SYMBOL_SUM_STRIDE 1024
+// Messages of up to this many symbols are unpacked (8 MB of values)
+#define SYMBOL_UNPACK_MAX (1 << 22)
+
+// The committed message as a sequence of symbols for a given bits-per-symbol.
+// The table points at the packed bytes, which the caller keeps alive (the
+// typed text or a mapped payload file). A message of up to
+// SYMBOL_UNPACK_MAX symbols is also unpacked once into 'values', so a
+// lookup is one indexed load. A larger one, such as a multi-gigabyte
+// payload, is read straight from the packed bytes with a shift and mask,
+// so it costs no more memory than a small one.
+// value_sums[j] is the sum of the first j * SYMBOL_SUM_STRIDE values (mod
+// 2^32); FSK uses it to find its phase at any symbol in bounded time.
+typedef struct {
+    const unsigned char* message;
+    int64_t message_len;
+    int64_t count;
+    int bits_per_symbol;
+    uint16_t* values; // one per symbol, NULL when read from the packed bytes
+    int64_t values_capacity;
+    uint32_t* value_sums;
+    int64_t sums_capacity;
+    uint32_t total_sum; // sum of all values (mod 2^32)
+} SymbolTable;
+
+// (Re)builds the table over 'message', reusing its storage where possible.
+// Returns false if the allocation fails, leaving an empty table.
+bool symbol_table_build(SymbolTable* table, const unsigned char* message, int64_t message_len, int bits_per_symbol);
+void symbol_table_free(SymbolTable* table);
+
+// Sum of the values of symbols [0, index), mod 2^32, for 0 <= index <= count
+uint32_t symbol_table_value_sum(const SymbolTable* table, int64_t index);
+
+int symbol_table_value_slow(const SymbolTable* table, int64_t index);
+
+// Value of symbol 'index' read from the packed bytes. Symbols are packed
+// MSB first; one symbol of up to 16 bits spans at most three bytes.
+static inline int symbol_table_value_packed(const SymbolTable* table, int64_t index) {
+    int bits = table->bits_per_symbol;
+    int64_t start_bit = index * bits;
+    int64_t byte = start_bit >> 3;
+    // A message shorter than one symbol is the only case that runs past the
+    // last byte
+    if (byte + ((start_bit & 7) + bits + 7) / 8 > table->message_len) return symbol_table_value_slow(table, index);
+
+    const unsigned char* p = table->message + byte;
+    uint32_t word = (uint32_t)p[0] << 16;
+    int shift = (int)(start_bit & 7);
+    if (shift + bits > 8) word |= (uint32_t)p[1] << 8;
+    if (shift + bits > 16) word |= p[2];
+    return (int)((word >> (24 - shift - bits)) & ((1u << bits) - 1));
+}
+
+// Value of symbol 'index' (0 <= index < count)
+static inline int symbol_table_value(const SymbolTable* table, int64_t index) {
+    if (table->values != NULL) return table->values[index];
+    return symbol_table_value_packed(table, index);
+}
+
+#endif // SYMBOLS_H
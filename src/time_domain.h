@@ -2,12 +2,14 @@
 #define TIME_DOMAIN_H
 
 #include "shared.h"
+#include "modulator.h"
 
 void draw_time_domain_view(
     SDL_Renderer* renderer,
-    const char* activeMessage,
-    int activeMessageLength,
-    ModulationType current_mod_type
+    Waveform* waveform
 );
 
-#endif // TIME_DOMAIN_H
\ No newline at end of file
+// Frees the display resampler kept between frames
+void time_domain_free_cache(void);
+
+#endif // TIME_DOMAIN_H
@@ -0,0 +1,243 @@
+#include "welch.h"
+#include "fft_engine.h"
+#include "parallel.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Samples a task asks the source for at once (at least four segments), so
+// overlapping segments are read from one span instead of each separately
+#define WELCH_BATCH_SAMPLES 65536
+#define WELCH_MAX_OVERLAP 0.95
+
+struct Welch {
+    WelchParams params;
+    int hop; // samples from one segment to the next when all of them fit
+    FftRealPlan* plan;
+    double* window;
+    double scale; // 1 / (sample_rate * sum of window^2)
+};
+
+Welch* welch_create(const WelchParams* params) {
+    const int n = params->segment_size;
+    if (n < 2 || (n & (n - 1)) != 0 || !(params->overlap >= 0.0) || params->overlap > WELCH_MAX_OVERLAP ||
+        params->max_segments < 0 || !(params->sample_rate > 0.0)) return NULL;
+    Welch* welch = (Welch*)calloc(1, sizeof(Welch));
+    if (welch == NULL) return NULL;
+
+    welch->params = *params;
+    welch->hop = (int)lround(n * (1.0 - params->overlap));
+    if (welch->hop < 1) welch->hop = 1;
+    welch->plan = fft_real_plan_create(n);
+    welch->window = fft_buffer_alloc(n);
+    if (welch->plan == NULL || welch->window == NULL) {
+        welch_destroy(welch);
+        return NULL;
+    }
+
+    double power = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double value = 1.0;
+        if (params->window == WINDOW_HANN) {
+            value = 0.5 * (1 - cos(2 * M_PI * i / (n - 1)));
+        } else if (params->window == WINDOW_HAMMING) {
+            value = 0.54 - 0.46 * cos(2 * M_PI * i / (n - 1));
+        }
+        welch->window[i] = value;
+        power += value * value;
+    }
+    welch->scale = 1.0 / (params->sample_rate * power);
+    return welch;
+}
+
+void welch_destroy(Welch* welch) {
+    if (welch == NULL) return;
+    fft_real_plan_destroy(welch->plan);
+    aligned_buffer_free(welch->window);
+    free(welch);
+}
+
+int welch_bins(const Welch* welch) {
+    return welch->params.segment_size / 2 + 1;
+}
+
+int64_t welch_span(const Welch* welch, int segments) {
+    if (segments < 1) return 0;
+    return (int64_t)(segments - 1) * welch->hop + welch->params.segment_size;
+}
+
+// Segments that fit in 'count' samples at the full overlap
+static int64_t segments_fitting(const Welch* welch, int64_t count) {
+    const int n = welch->params.segment_size;
+    return count > n ? (count - n) / welch->hop + 1 : 1;
+}
+
+int welch_segment_count(const Welch* welch, int64_t count) {
+    int64_t segments = segments_fitting(welch, count);
+    if (welch->params.max_segments > 0 && segments > welch->params.max_segments) segments = welch->params.max_segments;
+    return segments > INT_MAX ? INT_MAX : (int)segments;
+}
+
+int welch_task_count(const Welch* welch, int64_t count) {
+    int segments = welch_segment_count(welch, count);
+    return segments < WELCH_TASKS ? segments : WELCH_TASKS;
+}
+
+// Start of segment 'index' of 'segments' relative to the range: a hop
+// apart if they all fit, otherwise spread evenly from the first sample to
+// the last segment that fits
+static int64_t segment_offset(const Welch* welch, int64_t count, int segments, int index) {
+    if (segments >= segments_fitting(welch, count)) return (int64_t)index * welch->hop;
+    if (segments < 2) return 0;
+    int64_t range = count - welch->params.segment_size;
+    int64_t whole = range / (segments - 1);
+    int64_t rest = range % (segments - 1);
+    return whole * index + rest * index / (segments - 1);
+}
+
+// What one thread needs to transform its segments
+typedef struct {
+    double* span;
+    double* x;
+    double* bins_real;
+    double* bins_imag;
+    Workspace* workspace; // the thread's, for the source
+} WelchScratch;
+
+typedef struct {
+    const Welch* welch;
+    WelchSource source;
+    void* context;
+    int64_t start;
+    int64_t count;
+    int segments;
+    int tasks;
+    double* sums; // one row of bins per task
+    WelchScratch* scratch; // one per thread, task t running on thread t % threads
+    int threads;
+    int capacity; // samples in a span
+    bool failed; // set by any task whose source fails, so only with __atomic_store_n
+} WelchJob;
+
+// Task t sums its own run of segments, in order, into row t
+static void welch_task(void* context, int task_index) {
+    WelchJob* job = (WelchJob*)context;
+    const Welch* welch = job->welch;
+    const int n = welch->params.segment_size;
+    const int bins = welch_bins(welch);
+    int first = (int)((int64_t)job->segments * task_index / job->tasks);
+    int end = (int)((int64_t)job->segments * (task_index + 1) / job->tasks);
+    double* sum = job->sums + (size_t)task_index * bins;
+
+    const int capacity = job->capacity;
+    const WelchScratch* scratch = &job->scratch[task_index % job->threads];
+    double* span = scratch->span;
+    double* x = scratch->x;
+    double* bins_real = scratch->bins_real;
+    double* bins_imag = scratch->bins_imag;
+
+    for (int s = first; s < end;) {
+        // As many segments as the span holds
+        int64_t offset = segment_offset(welch, job->count, job->segments, s);
+        int last = s + 1;
+        while (last < end && segment_offset(welch, job->count, job->segments, last) + n - offset <= capacity) last++;
+        int length = (int)(segment_offset(welch, job->count, job->segments, last - 1) + n - offset);
+        if (!job->source(job->context, task_index, job->start + offset, span, length, scratch->workspace)) {
+            __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        for (; s < last; ++s) {
+            const double* segment = span + (segment_offset(welch, job->count, job->segments, s) - offset);
+            for (int i = 0; i < n; ++i) x[i] = segment[i] * welch->window[i];
+            fft_real_forward(welch->plan, x, bins_real, bins_imag);
+            for (int k = 0; k < bins; ++k) sum[k] += bins_real[k] * bins_real[k] + bins_imag[k] * bins_imag[k];
+        }
+    }
+}
+
+// 'workspace' is the calling thread's scratch, and 'workspaces' the set
+// the source's comes from, already holding a workspace per thread; either
+// may be NULL to allocate
+static bool welch_run(const Welch* welch, WelchSource source, void* context, int64_t start, int64_t count,
+                      double* psd, int threads, Workspace* workspace, WorkspaceSet* workspaces) {
+    const int n = welch->params.segment_size;
+    const int bins = welch_bins(welch);
+    int segments = welch_segment_count(welch, count);
+    int tasks = welch_task_count(welch, count);
+    threads = parallel_thread_count(threads);
+    if (threads > tasks) threads = tasks;
+
+    // All the scratch is taken here, on the calling thread, and given back
+    // on the way out
+    Workspace local = {0};
+    Workspace* scratch = workspace != NULL ? workspace : &local;
+    size_t mark = workspace_mark(scratch);
+    WelchJob job = { welch, source, context, start, count, segments, tasks, NULL, NULL, threads, 0, false };
+    job.capacity = 4 * n > WELCH_BATCH_SAMPLES ? 4 * n : WELCH_BATCH_SAMPLES;
+    job.sums = workspace_doubles(scratch, (size_t)tasks * bins);
+    job.scratch = (WelchScratch*)workspace_alloc(scratch, threads * sizeof(WelchScratch));
+    bool ok = job.sums != NULL && job.scratch != NULL;
+    for (int t = 0; ok && t < threads; ++t) {
+        job.scratch[t].span = workspace_doubles(scratch, job.capacity);
+        job.scratch[t].x = workspace_doubles(scratch, n);
+        job.scratch[t].bins_real = workspace_doubles(scratch, bins);
+        job.scratch[t].bins_imag = workspace_doubles(scratch, bins);
+        job.scratch[t].workspace = workspaces != NULL ? &workspaces->items[t] : NULL;
+        ok = job.scratch[t].span != NULL && job.scratch[t].x != NULL && job.scratch[t].bins_real != NULL &&
+             job.scratch[t].bins_imag != NULL;
+    }
+
+    if (ok) {
+        memset(job.sums, 0, (size_t)tasks * bins * sizeof(double));
+        parallel_run(welch_task, &job, tasks, threads);
+        ok = !__atomic_load_n(&job.failed, __ATOMIC_RELAXED);
+    }
+
+    if (ok) {
+        // Every bin but DC and Nyquist also stands for its negative frequency
+        double scale = welch->scale / segments;
+        for (int k = 0; k < bins; ++k) {
+            double total = 0.0;
+            for (int t = 0; t < tasks; ++t) total += job.sums[(size_t)t * bins + k];
+            psd[k] = total * scale * (k > 0 && k < bins - 1 ? 2.0 : 1.0);
+        }
+    }
+    workspace_release(scratch, mark);
+    workspace_free(&local);
+    return ok;
+}
+
+bool welch_psd(const Welch* welch, WelchSource source, void* context, int64_t start, int64_t count,
+               double* psd, int threads, WorkspaceSet* workspaces) {
+    // Grown first, so the first entry stays put while it is in use
+    int used = parallel_thread_count(threads);
+    int tasks = welch_task_count(welch, count);
+    if (used > tasks) used = tasks;
+    if (workspaces != NULL && !workspace_set_reserve(workspaces, used)) return false;
+    return welch_run(welch, source, context, start, count, psd, threads,
+                     workspaces != NULL ? &workspaces->items[0] : NULL, workspaces);
+}
+
+typedef struct {
+    const double* samples;
+    int64_t count;
+} MemorySource;
+
+// Past the end of the samples is silence
+static bool memory_source(void* context, int task, int64_t start, double* out, int count, Workspace* workspace) {
+    (void)task;
+    (void)workspace;
+    const MemorySource* memory = (const MemorySource*)context;
+    int available = start < memory->count ? (int)(memory->count - start < count ? memory->count - start : count) : 0;
+    if (available > 0) memcpy(out, memory->samples + start, available * sizeof(double));
+    for (int i = available; i < count; ++i) out[i] = 0.0;
+    return true;
+}
+
+bool welch_psd_samples(const Welch* welch, const double* samples, int64_t count, double* psd, int threads,
+                       Workspace* workspace) {
+    MemorySource memory = { samples, count };
+    return welch_run(welch, memory_source, &memory, 0, count, psd, threads, workspace, NULL);
+}
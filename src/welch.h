@@ -0,0 +1,65 @@
+#ifndef WELCH_H
+#define WELCH_H
+
+#include "dsp_common.h"
+#include "workspace.h"
+#include <stdint.h>
+
+// Welch's averaged power spectral density: the signal is cut into
+// windowed, overlapping segments and their periodograms averaged, which
+// trades frequency resolution for a far smoother estimate than a single
+// transform.
+//
+// The segments are split into WELCH_TASKS fixed runs, each summed by one
+// task in order and the runs then added in order, so the estimate comes
+// out bit-identical whatever the thread count.
+#define WELCH_TASKS 64
+
+typedef struct {
+    int segment_size;   // a power of two, at least 2
+    double overlap;     // fraction of a segment shared with the next, 0 to 0.95
+    int max_segments;   // 0 for every segment that fits; if fewer, they are spread evenly
+    WindowType window;
+    double sample_rate;
+} WelchParams;
+
+// The plan, window and segment spacing, read-only once built and shared
+// between threads
+typedef struct Welch Welch;
+
+// NULL if the parameters are out of range or an allocation fails
+Welch* welch_create(const WelchParams* params);
+void welch_destroy(Welch* welch);
+
+int welch_bins(const Welch* welch); // segment_size / 2 + 1
+// Samples spanned by 'segments' consecutive segments
+int64_t welch_span(const Welch* welch, int segments);
+// Segments averaged over 'count' samples; at least 1, padded with
+// whatever the source returns past the range if it is shorter than a
+// segment
+int welch_segment_count(const Welch* welch, int64_t count);
+// Tasks welch_psd runs for 'count' samples, for sources that keep state
+// per task
+int welch_task_count(const Welch* welch, int64_t count);
+
+// Fills 'out' with samples [start, start + count) of the signal. Called
+// from the worker threads; 'task' is below welch_task_count and no two
+// threads share one at a time. 'workspace' is the running thread's own
+// scratch, to be given back before returning, or NULL to allocate.
+typedef bool (*WelchSource)(void* context, int task, int64_t start, double* out, int count, Workspace* workspace);
+
+// One-sided PSD of samples [start, start + count), in the signal's units
+// squared per Hz, into 'psd' (welch_bins values). 'threads' as for
+// parallel_run. The sums and per-thread buffers come from the first of
+// 'workspaces' and the source's scratch from its thread's; the set grows
+// to the thread count and everything is released before returning. NULL
+// allocates it all for the call. False if an allocation or the source
+// failed.
+bool welch_psd(const Welch* welch, WelchSource source, void* context, int64_t start, int64_t count,
+               double* psd, int threads, WorkspaceSet* workspaces);
+// The same over samples already in memory, with the sums and buffers from
+// 'workspace' (NULL to allocate)
+bool welch_psd_samples(const Welch* welch, const double* samples, int64_t count, double* psd, int threads,
+                       Workspace* workspace);
+
+#endif // WELCH_H
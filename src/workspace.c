@@ -0,0 +1,106 @@
+#include "workspace.h"
+#include "dsp_common.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Wide enough for a cache line and any vector width, as for the FFT buffers
+#define WORKSPACE_ALIGNMENT 64
+// Smallest overflow block, so a first pass of small requests doesn't take
+// a block for each
+#define WORKSPACE_MIN_BLOCK 65536
+
+struct WorkspaceBlock {
+    WorkspaceBlock* next; // the block taken before it
+    size_t start;         // position of its first byte
+    size_t size;
+};
+
+static size_t round_up(size_t bytes) {
+    return (bytes + WORKSPACE_ALIGNMENT - 1) / WORKSPACE_ALIGNMENT * WORKSPACE_ALIGNMENT;
+}
+
+// The header is padded to a whole line so the data after it stays aligned
+#define WORKSPACE_HEADER round_up(sizeof(WorkspaceBlock))
+
+void* workspace_alloc(Workspace* workspace, size_t bytes) {
+    bytes = round_up(bytes > 0 ? bytes : 1);
+    WorkspaceBlock* block = workspace->overflow;
+    unsigned char* piece;
+
+    if (block == NULL && workspace->used + bytes <= workspace->capacity) {
+        piece = workspace->base + workspace->used;
+    } else if (block != NULL && workspace->used + bytes <= block->start + block->size) {
+        piece = (unsigned char*)block + WORKSPACE_HEADER + (workspace->used - block->start);
+    } else {
+        // Doesn't fit: a block of its own, at least as large as the main one
+        size_t size = bytes > workspace->capacity ? bytes : workspace->capacity;
+        if (size < WORKSPACE_MIN_BLOCK) size = WORKSPACE_MIN_BLOCK;
+        block = (WorkspaceBlock*)aligned_buffer_alloc(WORKSPACE_ALIGNMENT, WORKSPACE_HEADER + size);
+        if (block == NULL) return NULL;
+        workspace->allocations++;
+        block->next = workspace->overflow;
+        block->start = workspace->used;
+        block->size = size;
+        workspace->overflow = block;
+        piece = (unsigned char*)block + WORKSPACE_HEADER;
+    }
+
+    workspace->used += bytes;
+    if (workspace->used > workspace->peak) workspace->peak = workspace->used;
+    return piece;
+}
+
+double* workspace_doubles(Workspace* workspace, size_t count) {
+    return (double*)workspace_alloc(workspace, count * sizeof(double));
+}
+
+size_t workspace_mark(const Workspace* workspace) {
+    return workspace->used;
+}
+
+void workspace_release(Workspace* workspace, size_t mark) {
+    while (workspace->overflow != NULL && workspace->overflow->start >= mark) {
+        WorkspaceBlock* block = workspace->overflow;
+        workspace->overflow = block->next;
+        aligned_buffer_free(block);
+    }
+    if (mark < workspace->used) workspace->used = mark;
+}
+
+void workspace_reset(Workspace* workspace) {
+    workspace_release(workspace, 0);
+    // The same requests in the same order fit in the peak without the gaps
+    // left at the ends of the blocks, so this is the last growth at these
+    // sizes
+    if (workspace->peak > workspace->capacity) {
+        aligned_buffer_free(workspace->base);
+        workspace->base = (unsigned char*)aligned_buffer_alloc(WORKSPACE_ALIGNMENT, workspace->peak);
+        workspace->capacity = workspace->base != NULL ? workspace->peak : 0;
+        if (workspace->base != NULL) workspace->allocations++;
+    }
+}
+
+void workspace_free(Workspace* workspace) {
+    workspace_release(workspace, 0);
+    aligned_buffer_free(workspace->base);
+    workspace->base = NULL;
+    workspace->capacity = 0;
+    workspace->peak = 0;
+}
+
+bool workspace_set_reserve(WorkspaceSet* set, int count) {
+    if (count <= set->count) return true;
+    Workspace* grown = (Workspace*)realloc(set->items, count * sizeof(Workspace));
+    if (grown == NULL) return false;
+    memset(grown + set->count, 0, (count - set->count) * sizeof(Workspace));
+    set->items = grown;
+    set->count = count;
+    return true;
+}
+
+void workspace_set_free(WorkspaceSet* set) {
+    for (int i = 0; i < set->count; ++i) workspace_free(&set->items[i]);
+    free(set->items);
+    set->items = NULL;
+    set->count = 0;
+}
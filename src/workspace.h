@@ -0,0 +1,53 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Scratch memory that is reused instead of allocated on every call: an
+// arena handing out aligned pieces of one block, given back in stack order
+// down to a mark or all at once by a reset. A request that doesn't fit
+// gets a block of its own, and the next reset replaces the lot with one
+// block as large as the most ever in use, so once the sizes settle the
+// arena stops allocating until they grow again.
+//
+// A workspace is used by one thread at a time.
+typedef struct WorkspaceBlock WorkspaceBlock;
+
+typedef struct {
+    unsigned char* base;      // the main block
+    size_t capacity;
+    size_t used;              // position of the next piece, past the main block once it overflows
+    size_t peak;              // most ever in use at once
+    WorkspaceBlock* overflow; // blocks taken since the last reset, newest first
+    int64_t allocations;      // blocks ever requested from the system
+} Workspace;
+
+// 'bytes' aligned for the widest vectors, valid until released. NULL if an
+// allocation fails.
+void* workspace_alloc(Workspace* workspace, size_t bytes);
+double* workspace_doubles(Workspace* workspace, size_t count);
+
+// Everything allocated after the mark is released together
+size_t workspace_mark(const Workspace* workspace);
+void workspace_release(Workspace* workspace, size_t mark);
+
+// Releases everything and, if the arena overflowed, regrows the main block
+void workspace_reset(Workspace* workspace);
+void workspace_free(Workspace* workspace);
+
+// One workspace per thread of a parallel run, kept by the caller between
+// runs so the workers' scratch is reused as well: items[t] belongs to
+// share t of parallel_run, items[0] to the calling thread.
+typedef struct {
+    Workspace* items;
+    int count;
+} WorkspaceSet;
+
+// Makes sure the set holds at least 'count' workspaces; call it before the
+// run, on the calling thread. False if an allocation failed.
+bool workspace_set_reserve(WorkspaceSet* set, int count);
+void workspace_set_free(WorkspaceSet* set);
+
+#endif // WORKSPACE_H
@@ -0,0 +1,131 @@
+// Checks that the channel's output is a function of the sample index
+// alone: rendering a message through every impairment at once comes out
+// bit-identical in one call, in odd-sized pieces and across threads
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "modulator.h"
+#include "mod_kernels.h"
+#include "fft_kernels.h"
+#include "constellation.h"
+#include "noise.h"
+#include "parallel.h"
+
+#define MESSAGE_BYTES 8192
+#define THREADS 4
+
+typedef struct {
+    const char* name;
+    double phase_noise_bandwidth; // 10 Hz runs the filter at every sample, 0.5 Hz on a grid
+    FadingModel fading;
+} Case;
+
+static const Case cases[] = {
+    { "rayleigh, phase noise at every sample", 10.0, FADING_RAYLEIGH },
+    { "rician, phase noise on a grid", 0.5, FADING_RICIAN },
+};
+
+// Piece lengths cycled through; none divides another or the block sizes
+static const int piece_lengths[] = { 1, 7, 313, 4099, 12289, 2 };
+
+static bool render_pieces(const ModulatorParams* params, const SymbolTable* symbols, const Channel* channel,
+                          double* out, int count, int threads, WorkspaceSet* workspaces) {
+    int piece = 0;
+    for (int at = 0; at < count; piece = (piece + 1) % (int)(sizeof(piece_lengths) / sizeof(piece_lengths[0]))) {
+        int n = count - at < piece_lengths[piece] ? count - at : piece_lengths[piece];
+        if (!modulator_render_range(params, symbols, channel, at, out + at, n, threads, workspaces)) return false;
+        at += n;
+    }
+    return true;
+}
+
+int main(void) {
+    nco_init_tables();
+    noise_init_tables();
+    mod_kernels_init();
+    fft_kernels_init();
+    parallel_start(THREADS);
+
+    unsigned char message[MESSAGE_BYTES];
+    uint32_t state = 12345;
+    for (int i = 0; i < MESSAGE_BYTES; ++i) {
+        state = state * 1664525u + 1013904223u;
+        message[i] = (unsigned char)(state >> 24);
+    }
+
+    ModulatorParams params;
+    params.mod_type = MOD_QAM;
+    params.bits_per_symbol = 4;
+    params.samples_per_symbol = 8;
+    params.amplitude = 1.0;
+    params.frequency = 1000.0;
+    params.sampling_rate = 4000.0;
+    params.rolloff = 0.35;
+    params.pulse_shape = PULSE_ROOT_RAISED_COSINE;
+    params.pulse_span = PULSE_SHAPER_SPAN;
+    params.gaussian_bt = 0.5;
+    params.carrier_precision = NCO_PRECISION_INTERP_LUT;
+    params.sample_precision = SAMPLE_PRECISION_DOUBLE;
+
+    SymbolTable symbols = {0};
+    if (!symbol_table_build(&symbols, message, MESSAGE_BYTES, params.bits_per_symbol)) {
+        printf("FAIL symbol table\n");
+        return 1;
+    }
+    int count = (int)modulator_total_samples(&params, &symbols);
+    double signal_power = modulator_signal_power(&params, &symbols);
+
+    int failures = 0;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        ChannelParams channel_params = {0};
+        channel_params.snr_db = 20.0;
+        channel_params.noise_seed = 99;
+        channel_params.multipath = MULTIPATH_THREE_RAY;
+        channel_params.cfo_hz = 5.0;
+        channel_params.phase_noise_deg = 3.0;
+        channel_params.phase_noise_bandwidth = cases[c].phase_noise_bandwidth;
+        channel_params.dc_offset = 0.01;
+        channel_params.iq_gain_db = 0.5;
+        channel_params.iq_phase_deg = 2.0;
+        channel_params.fading = cases[c].fading;
+        channel_params.doppler_hz = 2.0;
+        channel_params.rician_k_db = 6.0;
+        Channel* channel = channel_create(&channel_params, params.sampling_rate, params.frequency,
+                                          params.samples_per_symbol, signal_power);
+
+        double* whole = (double*)malloc(count * sizeof(double));
+        double* pieces = (double*)malloc(count * sizeof(double));
+        double* threaded = (double*)malloc(count * sizeof(double));
+        double* both = (double*)malloc(count * sizeof(double));
+        WorkspaceSet workspaces = {0};
+        bool ok = channel != NULL && whole != NULL && pieces != NULL && threaded != NULL && both != NULL &&
+                  modulator_render_range(&params, &symbols, channel, 0, whole, count, 1, NULL) &&
+                  render_pieces(&params, &symbols, channel, pieces, count, 1, &workspaces) &&
+                  modulator_render_range(&params, &symbols, channel, 0, threaded, count, THREADS, &workspaces) &&
+                  render_pieces(&params, &symbols, channel, both, count, THREADS, NULL);
+
+        bool same_pieces = ok && memcmp(whole, pieces, count * sizeof(double)) == 0;
+        bool same_threads = ok && memcmp(whole, threaded, count * sizeof(double)) == 0;
+        bool same_both = ok && memcmp(whole, both, count * sizeof(double)) == 0;
+        printf("%s %s: pieces %s, %d threads %s, both %s over %d samples\n",
+               same_pieces && same_threads && same_both ? "ok  " : "FAIL", cases[c].name,
+               same_pieces ? "same" : "differ", THREADS, same_threads ? "same" : "differ",
+               same_both ? "same" : "differ", count);
+        if (!(same_pieces && same_threads && same_both)) failures++;
+
+        workspace_set_free(&workspaces);
+        free(whole);
+        free(pieces);
+        free(threaded);
+        free(both);
+        channel_destroy(channel);
+    }
+
+    symbol_table_free(&symbols);
+    pulse_shaper_free_cache();
+    constellation_free_tables();
+    parallel_stop();
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+// Checks every FFT kernel set the machine supports against the radix-2
+// reference, for the complex transforms both ways and the real transform
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "dsp_common.h"
+#include "fft_engine.h"
+#include "fft_kernels.h"
+
+#define MAX_BITS 16
+// Error relative to the rms of the reference; the kernels measure ~1e-15
+#define ERROR_BOUND 1e-14
+
+static const char* const kernel_names[] = { "scalar", "sse2", "avx2", "avx512", "neon" };
+
+static uint32_t state = 12345;
+
+static double next_value(void) {
+    state = state * 1664525u + 1013904223u;
+    return (double)(state >> 8) / (1 << 24) * 2.0 - 1.0;
+}
+
+// Worst of the real and imaginary parts against the reference
+static double relative_error(const Complex* reference, const double* real, const double* imag, int n) {
+    double error = 0.0, power = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double dr = real[i] - reference[i].real;
+        double di = imag[i] - reference[i].imag;
+        error += dr * dr + di * di;
+        power += reference[i].real * reference[i].real + reference[i].imag * reference[i].imag;
+    }
+    return power > 0.0 ? sqrt(error / power) : sqrt(error);
+}
+
+static bool check_size(int n, double* worst) {
+    FftPlan* plan = fft_plan_create(n);
+    FftRealPlan* real_plan = n >= 2 ? fft_real_plan_create(n) : NULL;
+    Complex* reference = (Complex*)malloc(n * sizeof(Complex));
+    double* input = fft_buffer_alloc(n);
+    double* real = fft_buffer_alloc(n);
+    double* imag = fft_buffer_alloc(n);
+    bool ok = plan != NULL && (n < 2 || real_plan != NULL) && reference != NULL && input != NULL &&
+              real != NULL && imag != NULL;
+
+    // Forward and inverse of complex data
+    for (int inverse = 0; ok && inverse < 2; ++inverse) {
+        for (int i = 0; i < n; ++i) {
+            real[i] = reference[i].real = next_value();
+            imag[i] = reference[i].imag = next_value();
+        }
+        if (inverse) {
+            fft_reference_inverse(plan, reference);
+            fft_inverse(plan, real, imag);
+        } else {
+            fft_reference_forward(plan, reference);
+            fft_forward(plan, real, imag);
+        }
+        double error = relative_error(reference, real, imag, n);
+        if (error > *worst) *worst = error;
+        ok = error <= ERROR_BOUND;
+    }
+
+    // Real input, bins 0 to n / 2
+    if (ok && real_plan != NULL) {
+        for (int i = 0; i < n; ++i) {
+            input[i] = reference[i].real = next_value();
+            reference[i].imag = 0.0;
+        }
+        fft_reference_forward(plan, reference);
+        fft_real_forward(real_plan, input, real, imag);
+        double error = relative_error(reference, real, imag, n / 2 + 1);
+        if (error > *worst) *worst = error;
+        ok = error <= ERROR_BOUND;
+    }
+
+    fft_plan_destroy(plan);
+    fft_real_plan_destroy(real_plan);
+    free(reference);
+    aligned_buffer_free(input);
+    aligned_buffer_free(real);
+    aligned_buffer_free(imag);
+    return ok;
+}
+
+int main(void) {
+    fft_kernels_init();
+    int failures = 0;
+    for (size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); ++k) {
+        if (!fft_kernels_select(kernel_names[k])) {
+            printf("skip %s: not available\n", kernel_names[k]);
+            continue;
+        }
+        double worst = 0.0;
+        int failed_size = 0;
+        for (int bits = 1; bits <= MAX_BITS && failed_size == 0; ++bits) {
+            if (!check_size(1 << bits, &worst)) failed_size = 1 << bits;
+        }
+        if (failed_size != 0) {
+            printf("FAIL %s: size %d, error %.2e\n", kernel_names[k], failed_size, worst);
+            failures++;
+        } else {
+            printf("ok   %s: sizes 2 to %d, worst error %.2e\n", kernel_names[k], 1 << MAX_BITS, worst);
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
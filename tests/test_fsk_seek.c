@@ -0,0 +1,155 @@
+// Checks that seeking an FSK modulator lands on the phase sequential
+// generation accumulates, at symbols on and around the value sum
+// checkpoints and on a looped message's later laps, for bits per symbol
+// that straddle byte boundaries. Also checks the checkpointed sums of a
+// table too large to unpack against a running total.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "modulator.h"
+#include "mod_kernels.h"
+#include "noise.h"
+
+// Several checkpoint strides of symbols at every bits per symbol below
+#define MESSAGE_BYTES 5000
+#define SAMPLES_PER_SYMBOL 5
+// Symbols rendered after each seek
+#define RUN_SYMBOLS 3
+#define MAX_SEEKS 4096
+// Just over SYMBOL_UNPACK_MAX symbols at 3 bits each
+#define LARGE_MESSAGE_BYTES ((SYMBOL_UNPACK_MAX / 8 + 4096) * 3)
+
+static const int bit_counts[] = { 1, 3, 5, 7, 12 };
+
+static uint32_t state = 12345;
+
+static void fill_message(unsigned char* message, int64_t length) {
+    for (int64_t i = 0; i < length; ++i) {
+        state = state * 1664525u + 1013904223u;
+        message[i] = (unsigned char)(state >> 24);
+    }
+}
+
+// Symbols to seek to: every one of the first two checkpoint strides,
+// either side of each later checkpoint, and a spread in between
+static int seek_symbols(int64_t count, int64_t* out, int capacity) {
+    int n = 0;
+    for (int64_t symbol = 0; symbol <= 2 * SYMBOL_SUM_STRIDE && symbol < count && n < capacity; ++symbol) {
+        out[n++] = symbol;
+    }
+    for (int64_t j = 3; j * SYMBOL_SUM_STRIDE <= count && n + 3 <= capacity; ++j) {
+        for (int64_t d = -1; d <= 1; ++d) {
+            int64_t symbol = j * SYMBOL_SUM_STRIDE + d;
+            if (symbol < count) out[n++] = symbol;
+        }
+    }
+    for (int64_t symbol = 2 * SYMBOL_SUM_STRIDE + 1; symbol < count && n < capacity; symbol += 97) out[n++] = symbol;
+    if (n < capacity) out[n++] = count - 1;
+    return n;
+}
+
+// Seeks a fresh modulator to every chosen sample, a symbol start or a
+// sample into it, and compares a short run with the sequential render
+static bool seeks_match(const ModulatorParams* params, const SymbolTable* symbols, bool loop, const double* sequential,
+                        int64_t length, int64_t lap_symbols) {
+    int64_t targets[MAX_SEEKS];
+    int count = seek_symbols(symbols->count, targets, MAX_SEEKS);
+    double run[RUN_SYMBOLS * SAMPLES_PER_SYMBOL];
+    bool ok = true;
+    for (int t = 0; ok && t < count; ++t) {
+        for (int offset = 0; ok && offset < SAMPLES_PER_SYMBOL; offset += SAMPLES_PER_SYMBOL - 2) {
+            int64_t sample = (targets[t] + lap_symbols) * SAMPLES_PER_SYMBOL + offset;
+            int n = length - sample < (int64_t)(sizeof(run) / sizeof(run[0])) ? (int)(length - sample)
+                                                                            : (int)(sizeof(run) / sizeof(run[0]));
+            if (n <= 0) continue;
+            Modulator* mod = modulator_create(params, symbols, loop);
+            if (mod == NULL) return false;
+            modulator_seek(mod, sample);
+            ok = modulator_next(mod, run, n) == n && memcmp(run, sequential + sample, n * sizeof(double)) == 0;
+            modulator_destroy(mod);
+        }
+    }
+    return ok;
+}
+
+static bool check_bits(int bits, const unsigned char* message) {
+    ModulatorParams params;
+    params.mod_type = MOD_FSK;
+    params.bits_per_symbol = bits;
+    params.samples_per_symbol = SAMPLES_PER_SYMBOL;
+    params.amplitude = 1.0;
+    params.frequency = 300.0;
+    params.sampling_rate = 4000.0;
+    params.rolloff = 0.35;
+    params.pulse_shape = PULSE_RAISED_COSINE;
+    params.pulse_span = PULSE_SHAPER_SPAN;
+    params.gaussian_bt = 0.5;
+    params.carrier_precision = NCO_PRECISION_INTERP_LUT;
+    params.sample_precision = SAMPLE_PRECISION_DOUBLE;
+
+    SymbolTable symbols = {0};
+    if (!symbol_table_build(&symbols, message, MESSAGE_BYTES, bits)) return false;
+
+    // Two laps of the looped message, generated in one go, so the phase
+    // is carried from symbol to symbol the whole way
+    int64_t total = modulator_total_samples(&params, &symbols);
+    double* sequential = (double*)malloc(2 * total * sizeof(double));
+    Modulator* mod = modulator_create(&params, &symbols, true);
+    bool ok = sequential != NULL && mod != NULL && modulator_next(mod, sequential, (int)(2 * total)) == 2 * total;
+    modulator_destroy(mod);
+
+    bool first_lap = ok && seeks_match(&params, &symbols, false, sequential, total, 0);
+    bool second_lap = ok && seeks_match(&params, &symbols, true, sequential, 2 * total, symbols.count);
+    printf("%s FSK %d bits: %lld symbols, first lap %s, second lap %s\n", first_lap && second_lap ? "ok  " : "FAIL",
+           bits, (long long)symbols.count, first_lap ? "same" : "differ", second_lap ? "same" : "differ");
+
+    free(sequential);
+    symbol_table_free(&symbols);
+    return first_lap && second_lap;
+}
+
+// The checkpointed sum of a table read from the packed bytes, against
+// values added up one at a time, either side of every checkpoint and at
+// a spread of indices between
+static bool check_large_sums(void) {
+    unsigned char* message = (unsigned char*)malloc(LARGE_MESSAGE_BYTES);
+    SymbolTable symbols = {0};
+    bool ok = message != NULL;
+    if (ok) fill_message(message, LARGE_MESSAGE_BYTES);
+    ok = ok && symbol_table_build(&symbols, message, LARGE_MESSAGE_BYTES, 3);
+    bool packed = ok && symbols.values == NULL;
+
+    uint32_t running = 0;
+    for (int64_t i = 0; ok && i <= symbols.count; ++i) {
+        int64_t phase = i % SYMBOL_SUM_STRIDE;
+        if (phase <= 1 || phase == SYMBOL_SUM_STRIDE - 1 || i % 101 == 0) {
+            ok = symbol_table_value_sum(&symbols, i) == running;
+        }
+        if (i < symbols.count) running += (uint32_t)symbol_table_value(&symbols, i);
+    }
+    ok = ok && running == symbols.total_sum;
+    printf("%s packed table of %lld symbols: sums %s\n", ok && packed ? "ok  " : "FAIL", (long long)symbols.count,
+           !packed ? "not packed" : ok ? "match" : "differ");
+
+    symbol_table_free(&symbols);
+    free(message);
+    return ok && packed;
+}
+
+int main(void) {
+    nco_init_tables();
+    noise_init_tables();
+    mod_kernels_init();
+
+    unsigned char message[MESSAGE_BYTES];
+    fill_message(message, MESSAGE_BYTES);
+
+    int failures = 0;
+    for (size_t b = 0; b < sizeof(bit_counts) / sizeof(bit_counts[0]); ++b) {
+        if (!check_bits(bit_counts[b], message)) failures++;
+    }
+    if (!check_large_sums()) failures++;
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+// Checks every modulation kernel set the machine supports against the
+// scalar one, at lengths around each vector width so the tails are covered
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mod_kernels.h"
+
+#define MAX_LENGTH 1030
+// Inputs are within +-1, so outputs stay within a few units; the sets
+// differ only where fused multiply-add rounds once instead of twice
+#define DOUBLE_BOUND 1e-14
+#define FLOAT_BOUND 2e-6
+#define SENTINEL 1234.5
+
+static const char* const kernel_names[] = { "sse2", "avx2", "avx512", "neon" };
+
+static uint32_t state = 12345;
+
+static double next_value(void) {
+    state = state * 1664525u + 1013904223u;
+    return (double)(state >> 8) / (1 << 24) * 2.0 - 1.0;
+}
+
+typedef struct {
+    double a[MAX_LENGTH + 1], b[MAX_LENGTH + 1], c[MAX_LENGTH + 1], d[MAX_LENGTH + 1];
+    double expected[MAX_LENGTH + 1], actual[MAX_LENGTH + 1];
+    float a_f32[MAX_LENGTH + 1], b_f32[MAX_LENGTH + 1], c_f32[MAX_LENGTH + 1], d_f32[MAX_LENGTH + 1];
+    float expected_f32[MAX_LENGTH + 1], actual_f32[MAX_LENGTH + 1];
+} Buffers;
+
+static void fill(Buffers* buffers, int n) {
+    for (int i = 0; i < n; ++i) {
+        buffers->a[i] = next_value();
+        buffers->b[i] = next_value();
+        buffers->c[i] = next_value();
+        buffers->d[i] = next_value();
+        buffers->a_f32[i] = (float)buffers->a[i];
+        buffers->b_f32[i] = (float)buffers->b[i];
+        buffers->c_f32[i] = (float)buffers->c[i];
+        buffers->d_f32[i] = (float)buffers->d[i];
+        buffers->expected[i] = buffers->actual[i] = next_value();
+        buffers->expected_f32[i] = buffers->actual_f32[i] = (float)buffers->expected[i];
+    }
+    // Past the end must be left alone
+    buffers->expected[n] = buffers->actual[n] = SENTINEL;
+    buffers->expected_f32[n] = buffers->actual_f32[n] = (float)SENTINEL;
+}
+
+// Worst difference between the outputs, sentinel included
+static double difference(const Buffers* buffers, int n, bool single) {
+    double worst = 0.0;
+    for (int i = 0; i <= n; ++i) {
+        double diff = single ? fabs((double)buffers->actual_f32[i] - buffers->expected_f32[i])
+                             : fabs(buffers->actual[i] - buffers->expected[i]);
+        if (!(diff <= worst)) worst = diff; // NaN counts as the worst
+    }
+    return worst;
+}
+
+static const char* check_length(const ModKernels* reference, const ModKernels* kernels, Buffers* buffers, int n,
+                                double* worst, double* worst_f32) {
+    const double a = 0.7, amplitude = 1.3;
+    double diff;
+
+    fill(buffers, n);
+    reference->axpy(buffers->expected, buffers->a, a, n);
+    kernels->axpy(buffers->actual, buffers->a, a, n);
+    if ((diff = difference(buffers, n, false)) > DOUBLE_BOUND) return "axpy";
+    if (diff > *worst) *worst = diff;
+
+    fill(buffers, n);
+    reference->mix_iq(buffers->expected, buffers->a, buffers->b, buffers->c, buffers->d, amplitude, n);
+    kernels->mix_iq(buffers->actual, buffers->a, buffers->b, buffers->c, buffers->d, amplitude, n);
+    if ((diff = difference(buffers, n, false)) > DOUBLE_BOUND) return "mix_iq";
+    if (diff > *worst) *worst = diff;
+
+    fill(buffers, n);
+    reference->mix_real(buffers->expected, buffers->a, buffers->b, amplitude, n);
+    kernels->mix_real(buffers->actual, buffers->a, buffers->b, amplitude, n);
+    if ((diff = difference(buffers, n, false)) > DOUBLE_BOUND) return "mix_real";
+    if (diff > *worst) *worst = diff;
+
+    fill(buffers, n);
+    reference->scale(buffers->expected, a, n);
+    kernels->scale(buffers->actual, a, n);
+    if ((diff = difference(buffers, n, false)) > DOUBLE_BOUND) return "scale";
+    if (diff > *worst) *worst = diff;
+
+    fill(buffers, n);
+    reference->axpy_f32(buffers->expected_f32, buffers->a_f32, (float)a, n);
+    kernels->axpy_f32(buffers->actual_f32, buffers->a_f32, (float)a, n);
+    if ((diff = difference(buffers, n, true)) > FLOAT_BOUND) return "axpy_f32";
+    if (diff > *worst_f32) *worst_f32 = diff;
+
+    fill(buffers, n);
+    reference->mix_iq_f32(buffers->expected_f32, buffers->a_f32, buffers->b_f32, buffers->c_f32, buffers->d_f32,
+                          (float)amplitude, n);
+    kernels->mix_iq_f32(buffers->actual_f32, buffers->a_f32, buffers->b_f32, buffers->c_f32, buffers->d_f32,
+                        (float)amplitude, n);
+    if ((diff = difference(buffers, n, true)) > FLOAT_BOUND) return "mix_iq_f32";
+    if (diff > *worst_f32) *worst_f32 = diff;
+
+    fill(buffers, n);
+    reference->mix_real_f32(buffers->expected_f32, buffers->a_f32, buffers->b_f32, (float)amplitude, n);
+    kernels->mix_real_f32(buffers->actual_f32, buffers->a_f32, buffers->b_f32, (float)amplitude, n);
+    if ((diff = difference(buffers, n, true)) > FLOAT_BOUND) return "mix_real_f32";
+    if (diff > *worst_f32) *worst_f32 = diff;
+
+    fill(buffers, n);
+    reference->scale_f32(buffers->expected_f32, (float)a, n);
+    kernels->scale_f32(buffers->actual_f32, (float)a, n);
+    if ((diff = difference(buffers, n, true)) > FLOAT_BOUND) return "scale_f32";
+    if (diff > *worst_f32) *worst_f32 = diff;
+    return NULL;
+}
+
+int main(void) {
+    mod_kernels_init();
+    if (!mod_kernels_select("scalar")) {
+        printf("FAIL scalar: not available\n");
+        return 1;
+    }
+    const ModKernels* reference = mod_kernels_get();
+    Buffers* buffers = (Buffers*)malloc(sizeof(Buffers));
+    if (buffers == NULL) return 1;
+
+    int failures = 0;
+    for (size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); ++k) {
+        if (!mod_kernels_select(kernel_names[k])) {
+            printf("skip %s: not available\n", kernel_names[k]);
+            continue;
+        }
+        const ModKernels* kernels = mod_kernels_get();
+        double worst = 0.0, worst_f32 = 0.0;
+        const char* failed = NULL;
+        int n = 0;
+        // Every length up to a few vectors, then a long one
+        for (; n <= 70 && failed == NULL; ++n) failed = check_length(reference, kernels, buffers, n, &worst, &worst_f32);
+        if (failed == NULL) failed = check_length(reference, kernels, buffers, n = MAX_LENGTH, &worst, &worst_f32);
+        else n--;
+
+        if (failed != NULL) {
+            printf("FAIL %s: %s at length %d\n", kernel_names[k], failed, n);
+            failures++;
+        } else {
+            printf("ok   %s: worst difference %.2e (double), %.2e (float)\n", kernel_names[k], worst, worst_f32);
+        }
+    }
+
+    free(buffers);
+    return failures > 0 ? 1 : 0;
+}
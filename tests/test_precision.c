@@ -0,0 +1,93 @@
+// Checks the single precision path against the double one, to the bounds
+// documented with SamplePrecision in modulator.h
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "modulator.h"
+#include "mod_kernels.h"
+#include "constellation.h"
+#include "noise.h"
+
+// The documented figures are ~5e-7 peak and ~6e-8 rms of the amplitude;
+// the bounds leave a factor of two for other compilers and kernel sets
+#define PEAK_BOUND 1e-6
+#define RMS_BOUND 1.2e-7
+#define MESSAGE_BYTES 2048
+
+typedef struct {
+    ModulationType type;
+    int bits_per_symbol;
+} Scheme;
+
+static const Scheme schemes[] = {
+    { MOD_ASK, 1 }, { MOD_ASK, 2 },
+    { MOD_FSK, 1 }, { MOD_FSK, 2 },
+    { MOD_PSK, 1 }, { MOD_PSK, 2 }, { MOD_PSK, 3 },
+    { MOD_QAM, 4 }, { MOD_QAM, 6 },
+    { MOD_APSK, 4 }, { MOD_APSK, 5 },
+};
+
+int main(void) {
+    nco_init_tables();
+    noise_init_tables();
+    mod_kernels_init();
+
+    unsigned char message[MESSAGE_BYTES];
+    uint32_t state = 12345;
+    for (int i = 0; i < MESSAGE_BYTES; ++i) {
+        state = state * 1664525u + 1013904223u;
+        message[i] = (unsigned char)(state >> 24);
+    }
+
+    int failures = 0;
+    for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); ++s) {
+        ModulatorParams params;
+        params.mod_type = schemes[s].type;
+        params.bits_per_symbol = schemes[s].bits_per_symbol;
+        params.samples_per_symbol = 50;
+        params.amplitude = 100.0;
+        params.frequency = 300.0;
+        params.sampling_rate = 4000.0;
+        params.rolloff = 0.35;
+        params.pulse_shape = PULSE_RAISED_COSINE;
+        params.pulse_span = PULSE_SHAPER_SPAN;
+        params.gaussian_bt = 0.5;
+        params.carrier_precision = NCO_PRECISION_INTERP_LUT;
+
+        SymbolTable symbols = {0};
+        if (!symbol_table_build(&symbols, message, MESSAGE_BYTES, params.bits_per_symbol)) {
+            printf("FAIL %s/%d: symbol table\n", modulation_name(params.mod_type), 1 << params.bits_per_symbol);
+            return 1;
+        }
+        int count = (int)modulator_total_samples(&params, &symbols);
+        double* reference = (double*)malloc(count * sizeof(double));
+        float* single = (float*)malloc(count * sizeof(float));
+
+        params.sample_precision = SAMPLE_PRECISION_DOUBLE;
+        bool ok = reference != NULL && single != NULL &&
+                  modulator_render_range(&params, &symbols, NULL, 0, reference, count, 1, NULL);
+        params.sample_precision = SAMPLE_PRECISION_SINGLE;
+        ok = ok && modulator_render_range_f32(&params, &symbols, NULL, 0, single, count, 1, NULL);
+
+        double peak = 0.0, square = 0.0;
+        for (int i = 0; ok && i < count; ++i) {
+            double error = fabs(single[i] - reference[i]) / params.amplitude;
+            if (error > peak) peak = error;
+            square += error * error;
+        }
+        double rms = count > 0 ? sqrt(square / count) : 0.0;
+        bool passed = ok && peak <= PEAK_BOUND && rms <= RMS_BOUND;
+        printf("%s %s/%d: peak %.2e rms %.2e over %d samples\n", passed ? "ok  " : "FAIL",
+               modulation_name(params.mod_type), 1 << params.bits_per_symbol, peak, rms, count);
+        if (!passed) failures++;
+
+        free(reference);
+        free(single);
+        symbol_table_free(&symbols);
+    }
+
+    pulse_shaper_free_cache();
+    constellation_free_tables();
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+// Checks that a root-raised-cosine transmitter and the matched filter from
+// pulse_shaper_matched_filter form a Nyquist pair: unit gain at the symbol
+// centre and next to no ISI at the other multiples of sps
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pulse_shaper.h"
+
+// Truncating both pulses to +-span symbols leaves some ISI, less the
+// longer the span and the larger the roll-off. The bounds are about 1.5
+// times the worst measured, which is at roll-off 0.1.
+typedef struct {
+    int span;
+    double bound;
+} SpanBound;
+
+static const SpanBound span_bounds[] = { { 4, 0.1 }, { 8, 0.02 }, { PULSE_SHAPER_MAX_SPAN, 0.005 } };
+static const double rolloffs[] = { 0.1, 0.2, 0.35, 0.5, 1.0 };
+static const int samples_per_symbol[] = { 2, 4, 8, 16, 50 };
+
+// Worst |pair response - ideal| at multiples of sps, for an even sps so the
+// transmitted pulse's centre falls on a sample
+static double worst_isi(double rolloff, int sps, int span, bool* ok) {
+    const PulseShaper* shaper = pulse_shaper_get(PULSE_ROOT_RAISED_COSINE, rolloff, sps, span);
+    int half = span * sps;
+    int num_taps = 2 * half + 1;
+    // The transmitted pulse spans the shaper's table, sps / 2 wider each side
+    int pulse_half = half + sps / 2;
+    double* pulse = (double*)calloc(2 * pulse_half + 1, sizeof(double));
+    double* matched = (double*)malloc(num_taps * sizeof(double));
+    *ok = shaper != NULL && pulse != NULL && matched != NULL &&
+          pulse_shaper_matched_filter(PULSE_ROOT_RAISED_COSINE, rolloff, sps, span, matched, num_taps) == num_taps;
+    double worst = 0.0;
+
+    if (*ok) {
+        // taps[k * sps + phase] is the pulse at phase - (k - span + 0.5) * sps
+        for (int k = 0; k < shaper->num_taps; ++k) {
+            for (int phase = 0; phase < sps; ++phase) {
+                int t = phase - (k - span) * sps - sps / 2;
+                pulse[pulse_half + t] = shaper->taps[k * sps + phase];
+            }
+        }
+        for (int n = -(pulse_half + half) / sps * sps; n <= pulse_half + half; n += sps) {
+            double response = 0.0;
+            for (int m = -half; m <= half; ++m) {
+                int t = n - m;
+                if (t >= -pulse_half && t <= pulse_half) response += matched[half + m] * pulse[pulse_half + t];
+            }
+            double error = fabs(response - (n == 0 ? 1.0 : 0.0));
+            if (!(error <= worst)) worst = error;
+        }
+    }
+
+    free(pulse);
+    free(matched);
+    return worst;
+}
+
+int main(void) {
+    int failures = 0;
+    for (size_t s = 0; s < sizeof(span_bounds) / sizeof(span_bounds[0]); ++s) {
+        for (size_t r = 0; r < sizeof(rolloffs) / sizeof(rolloffs[0]); ++r) {
+            // Worst over every sps
+            double worst = 0.0;
+            bool ok = true;
+            for (size_t p = 0; ok && p < sizeof(samples_per_symbol) / sizeof(samples_per_symbol[0]); ++p) {
+                double isi = worst_isi(rolloffs[r], samples_per_symbol[p], span_bounds[s].span, &ok);
+                if (isi > worst) worst = isi;
+            }
+            bool passed = ok && worst <= span_bounds[s].bound;
+            printf("%s RRC span %d rolloff %.2f: worst ISI %.2e\n", passed ? "ok  " : "FAIL", span_bounds[s].span,
+                   rolloffs[r], worst);
+            if (!passed) failures++;
+        }
+    }
+    pulse_shaper_free_cache();
+    return failures > 0 ? 1 : 0;
+}
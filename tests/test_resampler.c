@@ -0,0 +1,106 @@
+// Checks the resampler against the ideal: a tone comes out as the same
+// tone sampled at the output rate, and the output is as long as
+// resampler_output_length says, up to and including the last output that
+// falls inside the input
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "dsp_common.h"
+#include "resampler.h"
+
+#define INPUT_SECONDS 1.0
+// Outputs this close to either end see the zeros past the input
+#define EDGE_OUTPUTS 400
+// The Kaiser filter's passband ripple measures up to ~1.2e-5 of the amplitude
+#define ERROR_BOUND 1e-4
+
+typedef struct {
+    double input_rate;
+    double output_rate;
+    double tone;
+} RateCase;
+
+static const RateCase rate_cases[] = {
+    { 4000.0, 44100.0, 1000.0 },   // up, L/M = 441/40
+    { 4000.0, 48000.0, 1234.5 },   // up by a whole factor
+    { 48000.0, 44100.0, 3000.0 },  // down a little
+    { 44100.0, 8000.0, 1500.0 },   // down, below the output's cutoff
+    { 10000.0, 7919.0, 700.0 },    // a prime number of outputs per second
+};
+
+// Worst |output - tone| away from the edges, with the output rendered in
+// two pieces to check those line up too
+static double tone_error(const Resampler* resampler, const RateCase* rc, int64_t input_length, int64_t output_length,
+                         bool* ok) {
+    int64_t first;
+    int count;
+    resampler_input_span(resampler, 0, (int)output_length, &first, &count);
+    double* in = (double*)malloc(count * sizeof(double));
+    double* out = (double*)malloc(output_length * sizeof(double));
+    *ok = in != NULL && out != NULL;
+    double worst = 0.0;
+
+    if (*ok) {
+        // The tone over the input, zeros outside it
+        for (int i = 0; i < count; ++i) {
+            int64_t index = first + i;
+            in[i] = index >= 0 && index < input_length ? cos(2.0 * M_PI * rc->tone * index / rc->input_rate) : 0.0;
+        }
+        int split = (int)(output_length / 3);
+        resampler_process(resampler, 0, in, first, out, split);
+        int64_t second_first;
+        int second_count;
+        resampler_input_span(resampler, split, (int)(output_length - split), &second_first, &second_count);
+        resampler_process(resampler, split, in + (second_first - first), second_first, out + split,
+                          (int)(output_length - split));
+
+        double output_rate = resampler_output_rate(resampler);
+        for (int64_t m = EDGE_OUTPUTS; m < output_length - EDGE_OUTPUTS; ++m) {
+            double error = fabs(out[m] - cos(2.0 * M_PI * rc->tone * m / output_rate));
+            if (!(error <= worst)) worst = error;
+        }
+    }
+
+    free(in);
+    free(out);
+    return worst;
+}
+
+int main(void) {
+    int failures = 0;
+    for (size_t c = 0; c < sizeof(rate_cases) / sizeof(rate_cases[0]); ++c) {
+        const RateCase* rc = &rate_cases[c];
+        Resampler* resampler = resampler_create(rc->input_rate, rc->output_rate);
+        if (resampler == NULL) {
+            printf("FAIL %.0f -> %.0f Hz: create\n", rc->input_rate, rc->output_rate);
+            failures++;
+            continue;
+        }
+
+        // The rates are whole numbers, so the exact fraction is theirs
+        bool rate_ok = resampler_output_rate(resampler) == rc->output_rate;
+
+        // Output m sits at input position m * input_rate / output_rate, so
+        // there are as many outputs as positions before the end of the input
+        bool length_ok = true;
+        int64_t input_length = (int64_t)(INPUT_SECONDS * rc->input_rate);
+        for (int64_t n = 0; n <= input_length; n += n < 100 ? 1 : 997) {
+            int64_t expected = 0;
+            while (expected * (int64_t)rc->input_rate < n * (int64_t)rc->output_rate) expected++;
+            if (resampler_output_length(resampler, n) != expected) length_ok = false;
+        }
+
+        bool ok;
+        int64_t output_length = resampler_output_length(resampler, input_length);
+        double worst = tone_error(resampler, rc, input_length, output_length, &ok);
+        bool passed = ok && rate_ok && length_ok && worst <= ERROR_BOUND;
+        printf("%s %.0f -> %.0f Hz: %.1f Hz tone worst error %.2e, rate %s, length %s\n", passed ? "ok  " : "FAIL",
+               rc->input_rate, rc->output_rate, rc->tone, worst, rate_ok ? "exact" : "wrong",
+               length_ok ? "right" : "wrong");
+        if (!passed) failures++;
+        resampler_destroy(resampler);
+    }
+    return failures > 0 ? 1 : 0;
+}